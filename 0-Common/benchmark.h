@@ -0,0 +1,272 @@
+//
+// Created by abdelaziz on 10/17/2026.
+//
+
+#ifndef IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_BENCHMARK_H
+#define IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_BENCHMARK_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+
+// Keeps the compiler from discarding a result that is never used
+template <typename T>
+inline void benchmarkKeep(const T& value) {
+#if defined(__GNUC__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+// Timings of one benchmark, per call of the measured function
+struct BenchmarkStats {
+    std::string name;
+    std::string unit;           // what one item is: "hash", "root", "block"...
+    double itemsPerCall;
+    size_t repetitions;
+    size_t callsPerRepetition;
+    double minNs;
+    double medianNs;
+    double p90Ns;
+    double p99Ns;
+    double meanNs;
+    double maxNs;
+
+    double itemsPerSecond() const {
+        return medianNs > 0 ? itemsPerCall * 1e9 / medianNs : 0;
+    }
+};
+
+// Runs each benchmark as warmup repetitions then measured repetitions.
+// A repetition repeats the call until it lasts at least minRepetitionMs, so
+// calls of a few nanoseconds are timed as precisely as whole chains; the
+// percentiles are taken over the repetitions.
+//
+// Every program built on it accepts:
+//   --json FILE          write the results as JSON
+//   --baseline FILE      compare medians with a JSON file written earlier
+//   --tolerance X        slowdown flagged as a regression (default 0.10 = 10%)
+//   --repetitions N      measured repetitions per benchmark (default 20)
+//   --filter TEXT        only benchmarks whose name contains TEXT
+class BenchmarkSuite {
+private:
+    std::string suiteName;
+    size_t warmup;
+    size_t repetitions;
+    double minRepetitionMs;
+    std::string filter;
+    std::string jsonPath;
+    std::string baselinePath;
+    double tolerance;
+    std::vector<BenchmarkStats> results;
+
+    static double percentile(const std::vector<double>& sorted, double p) {
+        size_t rank = (size_t)(p * (sorted.size() - 1) + 0.5);
+        return sorted[std::min(rank, sorted.size() - 1)];
+    }
+
+    static std::string jsonString(const std::string& text, const std::string& key) {
+        std::string pattern = "\"" + key + "\": \"";
+        size_t start = text.find(pattern);
+        if(start == std::string::npos) {
+            return "";
+        }
+        start += pattern.size();
+        return text.substr(start, text.find('"', start) - start);
+    }
+
+    static double jsonNumber(const std::string& text, const std::string& key) {
+        std::string pattern = "\"" + key + "\": ";
+        size_t start = text.find(pattern);
+        if(start == std::string::npos) {
+            return 0;
+        }
+        return std::strtod(text.c_str() + start + pattern.size(), nullptr);
+    }
+
+public:
+    explicit BenchmarkSuite(const std::string& name, size_t warmupRepetitions = 3,
+                            size_t measuredRepetitions = 20, double repetitionMs = 5)
+            : suiteName(name), warmup(warmupRepetitions), repetitions(measuredRepetitions),
+              minRepetitionMs(repetitionMs), tolerance(0.10) {}
+
+    // Returns false on an unknown option
+    bool parseArguments(int argc, char** argv) {
+        for(int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if(arg == "--json" && hasValue) {
+                jsonPath = argv[++i];
+            } else if(arg == "--baseline" && hasValue) {
+                baselinePath = argv[++i];
+            } else if(arg == "--tolerance" && hasValue) {
+                tolerance = std::atof(argv[++i]);
+            } else if(arg == "--repetitions" && hasValue) {
+                repetitions = std::max(1, std::atoi(argv[++i]));
+            } else if(arg == "--filter" && hasValue) {
+                filter = argv[++i];
+            } else {
+                std::cerr << "Option inconnue: " << arg << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // fn() performs one call processing itemsPerCall items
+    template <typename Function>
+    void run(const std::string& name, const std::string& unit, double itemsPerCall, Function fn) {
+        if(!filter.empty() && name.find(filter) == std::string::npos) {
+            return;
+        }
+        typedef std::chrono::steady_clock Clock;
+
+        // Calibration: enough calls per repetition to last minRepetitionMs
+        size_t calls = 1;
+        while(true) {
+            Clock::time_point start = Clock::now();
+            for(size_t c = 0; c < calls; c++) {
+                fn();
+            }
+            double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            if(ms >= minRepetitionMs || calls >= ((size_t)1 << 30)) {
+                break;
+            }
+            calls = ms <= 0 ? calls * 16 : std::max(calls + 1, (size_t)(calls * minRepetitionMs * 1.2 / ms));
+        }
+
+        std::vector<double> samples;
+        for(size_t r = 0; r < warmup + repetitions; r++) {
+            Clock::time_point start = Clock::now();
+            for(size_t c = 0; c < calls; c++) {
+                fn();
+            }
+            double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            if(r >= warmup) {
+                samples.push_back(ns / calls);
+            }
+        }
+        std::sort(samples.begin(), samples.end());
+
+        BenchmarkStats stats;
+        stats.name = name;
+        stats.unit = unit;
+        stats.itemsPerCall = itemsPerCall;
+        stats.repetitions = samples.size();
+        stats.callsPerRepetition = calls;
+        stats.minNs = samples.front();
+        stats.medianNs = percentile(samples, 0.5);
+        stats.p90Ns = percentile(samples, 0.9);
+        stats.p99Ns = percentile(samples, 0.99);
+        stats.maxNs = samples.back();
+        double total = 0;
+        for(double s : samples) {
+            total += s;
+        }
+        stats.meanNs = total / samples.size();
+        results.push_back(stats);
+
+        std::cout << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(14) << stats.medianNs << " ns"
+                  << std::setw(14) << stats.p90Ns << " ns p90"
+                  << std::setw(16) << std::setprecision(0) << stats.itemsPerSecond() << " " << unit << "/s"
+                  << std::endl;
+    }
+
+    void writeJson(std::ostream& out) const {
+        out << "{" << std::endl;
+        out << "  \"suite\": \"" << suiteName << "\"," << std::endl;
+        out << "  \"results\": [" << std::endl;
+        out << std::setprecision(3) << std::fixed;
+        for(size_t i = 0; i < results.size(); i++) {
+            const BenchmarkStats& s = results[i];
+            // One result per line, which loadMedians relies on
+            out << "    {\"name\": \"" << s.name << "\", \"unit\": \"" << s.unit
+                << "\", \"items_per_call\": " << s.itemsPerCall
+                << ", \"repetitions\": " << s.repetitions
+                << ", \"calls_per_repetition\": " << s.callsPerRepetition
+                << ", \"min_ns\": " << s.minNs << ", \"median_ns\": " << s.medianNs
+                << ", \"p90_ns\": " << s.p90Ns << ", \"p99_ns\": " << s.p99Ns
+                << ", \"mean_ns\": " << s.meanNs << ", \"max_ns\": " << s.maxNs
+                << ", \"items_per_second\": " << s.itemsPerSecond() << "}"
+                << (i + 1 < results.size() ? "," : "") << std::endl;
+        }
+        out << "  ]" << std::endl;
+        out << "}" << std::endl;
+    }
+
+    // Median time per call of every benchmark of a file written by writeJson
+    static bool loadMedians(const std::string& path, std::map<std::string, double>& medians) {
+        std::ifstream in(path.c_str());
+        if(!in) {
+            return false;
+        }
+        std::string line;
+        while(std::getline(in, line)) {
+            std::string name = jsonString(line, "name");
+            if(!name.empty()) {
+                medians[name] = jsonNumber(line, "median_ns");
+            }
+        }
+        return true;
+    }
+
+    // Prints every benchmark against the baseline; returns the number of regressions
+    int compareWithBaseline(const std::string& path, std::ostream& out) const {
+        std::map<std::string, double> baseline;
+        if(!loadMedians(path, baseline)) {
+            out << "Pas de reference " << path << ", comparaison ignoree" << std::endl;
+            return 0;
+        }
+
+        int regressions = 0;
+        out << std::endl << "Comparaison avec " << path << " (tolerance " << tolerance * 100 << "%)" << std::endl;
+        for(const BenchmarkStats& s : results) {
+            std::map<std::string, double>::const_iterator it = baseline.find(s.name);
+            if(it == baseline.end() || it->second <= 0) {
+                out << "  " << std::left << std::setw(40) << s.name << " nouveau" << std::endl;
+                continue;
+            }
+            double change = s.medianNs / it->second - 1;
+            const char* verdict = "ok";
+            if(change > tolerance) {
+                verdict = "REGRESSION";
+                regressions++;
+            } else if(change < -tolerance) {
+                verdict = "plus rapide";
+            }
+            out << "  " << std::left << std::setw(40) << s.name << std::right << std::showpos
+                << std::setprecision(1) << std::setw(8) << change * 100 << "%" << std::noshowpos
+                << "  " << verdict << std::endl;
+        }
+        return regressions;
+    }
+
+    // Writes the JSON file and runs the comparison requested on the command
+    // line; the return value is meant for main (1 if a regression was found)
+    int finish() const {
+        if(!jsonPath.empty()) {
+            std::ofstream out(jsonPath.c_str());
+            writeJson(out);
+            std::cout << "Resultats ecrits dans " << jsonPath << std::endl;
+        }
+        if(!baselinePath.empty() && compareWithBaseline(baselinePath, std::cout) > 0) {
+            return 1;
+        }
+        return 0;
+    }
+
+    const std::vector<BenchmarkStats>& getResults() const { return results; }
+};
+
+#endif //IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_BENCHMARK_H
@@ -0,0 +1,81 @@
+//
+// Created by abdelaziz on 10/17/2026.
+//
+
+#ifndef IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_CHECKPOINTS_H
+#define IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_CHECKPOINTS_H
+
+#include <string>
+#include <map>
+#include <cstdint>
+#include "digest.h"
+#include "ed25519.h"
+
+// Known (height, block hash) pairs. A chain holding the checkpointed hash
+// at the highest checkpoint below its size trusts every block up to it
+// and only validates the blocks after; a chain with another block at any
+// checkpoint height is invalid.
+//
+// Checkpoints come hard-coded with the node, or signed by an authority
+// key: the signature covers SHA256(height as 8 big-endian bytes || hash).
+class Checkpoints {
+private:
+    std::map<uint64_t, std::string> hashes;
+
+public:
+    static Digest message(uint64_t height, const std::string& hash) {
+        std::string input;
+        for(int shift = 56; shift >= 0; shift -= 8) {
+            input.push_back((char)(uint8_t)(height >> shift));
+        }
+        return sha256Digest(input + hash);
+    }
+
+    static Signature sign(const Ed25519Key& authority, uint64_t height, const std::string& hash) {
+        return authority.sign(message(height, hash));
+    }
+
+    // Replaces any checkpoint at the same height
+    void add(uint64_t height, const std::string& hash) {
+        hashes[height] = hash;
+    }
+
+    // Returns false, adding nothing, if the signature does not verify
+    bool addSigned(uint64_t height, const std::string& hash, const Signature& signature, const PublicKey& authority) {
+        Digest digest = message(height, hash);
+        if(!ed25519Verify(authority, digest.data(), digest.size(), signature)) {
+            return false;
+        }
+        add(height, hash);
+        return true;
+    }
+
+    // nullptr if there is no checkpoint at height
+    const std::string* find(uint64_t height) const {
+        std::map<uint64_t, std::string>::const_iterator it = hashes.find(height);
+        return it == hashes.end() ? nullptr : &it->second;
+    }
+
+    // hashAt(h) is the hash of block h of a chain of size blocks. trusted
+    // is one past the highest checkpoint below size, 0 if there is none.
+    // Returns false if a block differs from its checkpoint, with trusted
+    // set to the lowest such height.
+    template <typename HashAt>
+    bool trustedPrefix(uint64_t size, HashAt hashAt, uint64_t& trusted) const {
+        trusted = 0;
+        for(std::map<uint64_t, std::string>::const_iterator it = hashes.begin();
+            it != hashes.end() && it->first < size; ++it) {
+            if(hashAt(it->first) != it->second) {
+                trusted = it->first;
+                return false;
+            }
+            trusted = it->first + 1;
+        }
+        return true;
+    }
+
+    size_t size() const { return hashes.size(); }
+    bool empty() const { return hashes.empty(); }
+};
+
+#endif //IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_CHECKPOINTS_H
@@ -0,0 +1,165 @@
+//
+// Created by abdelaziz on 10/17/2026.
+//
+
+#ifndef IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_DIFFICULTY_TARGET_H
+#define IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_DIFFICULTY_TARGET_H
+
+#include <string>
+#include <cstring>
+#include <cmath>
+#include "digest.h"
+
+// Number of zero bits at the start of a digest (256 for the zero digest)
+inline int leadingZeroBits(const Digest& digest) {
+    int bits = 0;
+    for(size_t i = 0; i < digest.size(); i++) {
+        if(digest[i] == 0) {
+            bits += 8;
+            continue;
+        }
+        for(uint8_t mask = 0x80; (digest[i] & mask) == 0; mask >>= 1) {
+            bits++;
+        }
+        break;
+    }
+    return bits;
+}
+
+// Proof-of-work target: a hash, read as a 256-bit big-endian number, is
+// valid when it is <= the target. Checking a candidate is one memcmp on the
+// raw digest, and the target can move by less than a factor of 2, unlike a
+// count of leading hex zeros (4 bits at a time).
+class DifficultyTarget {
+private:
+    Digest maximum;
+
+    // 256-bit value as 8 limbs of 32 bits, most significant first
+    static void toLimbs(const Digest& digest, uint64_t limbs[8]) {
+        for(int i = 0; i < 8; i++) {
+            limbs[i] = ((uint64_t)digest[4 * i] << 24) | ((uint64_t)digest[4 * i + 1] << 16)
+                       | ((uint64_t)digest[4 * i + 2] << 8) | digest[4 * i + 3];
+        }
+    }
+
+    static Digest fromLimbs(const uint64_t limbs[8]) {
+        Digest digest;
+        for(int i = 0; i < 8; i++) {
+            for(int b = 0; b < 4; b++) {
+                digest[4 * i + b] = (uint8_t)(limbs[i] >> (24 - 8 * b));
+            }
+        }
+        return digest;
+    }
+
+public:
+    // Accepts every hash: blocks without proof of work (PoS, genesis)
+    DifficultyTarget() {
+        maximum.fill(0xff);
+    }
+
+    explicit DifficultyTarget(const Digest& max) : maximum(max) {}
+
+    // Hashes starting with bits zero bits (0..256)
+    static DifficultyTarget fromLeadingZeroBits(int bits) {
+        Digest max;
+        max.fill(0xff);
+        for(int i = 0; i < bits && i < 256; i++) {
+            max[i / 8] &= (uint8_t)~(0x80 >> (i % 8));
+        }
+        return DifficultyTarget(max);
+    }
+
+    // The historical difficulty: hex hashes starting with zeros '0' characters
+    static DifficultyTarget fromHexZeros(int zeros) {
+        return fromLeadingZeroBits(4 * zeros);
+    }
+
+    // Returns false if hex is not 64 hex characters
+    static bool fromHex(const std::string& hex, DifficultyTarget& out) {
+        return hexToDigest(hex, out.maximum);
+    }
+
+    bool isMetBy(const Digest& digest) const {
+        return std::memcmp(digest.data(), maximum.data(), maximum.size()) <= 0;
+    }
+
+    // For hashes stored as hex; malformed hashes never meet a target
+    bool isMetByHex(const std::string& hex) const {
+        Digest digest;
+        return hexToDigest(hex, digest) && isMetBy(digest);
+    }
+
+    // Average number of hashes needed to meet the target, 2^256 / (target + 1)
+    double expectedHashes() const {
+        double value = 0;
+        for(size_t i = 0; i < maximum.size(); i++) {
+            value = value * 256 + maximum[i];
+        }
+        return std::ldexp(1.0, 256) / (value + 1);
+    }
+
+    // Difficulty in bits, fractional: log2 of expectedHashes()
+    double getDifficultyBits() const {
+        return std::log2(expectedHashes());
+    }
+
+    // target * numerator / denominator in exact integer arithmetic, so that
+    // every node retargeting from the same blocks gets the same bytes.
+    // Saturates at the easiest target; denominator must not be 0.
+    DifficultyTarget scaled(uint32_t numerator, uint32_t denominator) const {
+        uint64_t limbs[8];
+        toLimbs(maximum, limbs);
+
+        uint64_t carry = 0;
+        for(int i = 7; i >= 0; i--) {
+            uint64_t product = limbs[i] * numerator + carry;
+            limbs[i] = product & 0xffffffff;
+            carry = product >> 32;
+        }
+
+        uint64_t remainder = carry;
+        if(remainder >= denominator) {
+            return DifficultyTarget();
+        }
+        for(int i = 0; i < 8; i++) {
+            uint64_t current = (remainder << 32) | limbs[i];
+            limbs[i] = current / denominator;
+            remainder = current % denominator;
+        }
+        return DifficultyTarget(fromLimbs(limbs));
+    }
+
+    // Saturating sum, used to average the targets of a window of blocks
+    DifficultyTarget plus(const DifficultyTarget& other) const {
+        uint64_t a[8];
+        uint64_t b[8];
+        toLimbs(maximum, a);
+        toLimbs(other.maximum, b);
+        uint64_t carry = 0;
+        for(int i = 7; i >= 0; i--) {
+            uint64_t sum = a[i] + b[i] + carry;
+            a[i] = sum & 0xffffffff;
+            carry = sum >> 32;
+        }
+        return carry ? DifficultyTarget() : DifficultyTarget(fromLimbs(a));
+    }
+
+    // The harder (smaller) or easier (larger) of two targets
+    static const DifficultyTarget& harder(const DifficultyTarget& a, const DifficultyTarget& b) {
+        return std::memcmp(a.maximum.data(), b.maximum.data(), a.maximum.size()) <= 0 ? a : b;
+    }
+
+    static const DifficultyTarget& easier(const DifficultyTarget& a, const DifficultyTarget& b) {
+        return std::memcmp(a.maximum.data(), b.maximum.data(), a.maximum.size()) >= 0 ? a : b;
+    }
+
+    int getLeadingZeroBits() const { return leadingZeroBits(maximum); }
+    const Digest& getMaximum() const { return maximum; }
+    std::string toHex() const { return digestToHex(maximum); }
+
+    bool operator==(const DifficultyTarget& other) const { return maximum == other.maximum; }
+    bool operator!=(const DifficultyTarget& other) const { return maximum != other.maximum; }
+};
+
+#endif //IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_DIFFICULTY_TARGET_H
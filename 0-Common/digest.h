@@ -0,0 +1,74 @@
+//
+// Created by abdelaziz on 10/17/2026.
+//
+
+#ifndef IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_DIGEST_H
+#define IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_DIGEST_H
+
+#include <array>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <openssl/sha.h>
+
+// Raw SHA-256 output, kept as bytes so hot paths never touch iostreams
+typedef std::array<uint8_t, SHA256_DIGEST_LENGTH> Digest;
+
+inline Digest sha256Digest(const void* data, size_t size) {
+    Digest out;
+    SHA256((const unsigned char*)data, size, out.data());
+    return out;
+}
+
+inline Digest sha256Digest(const std::string& data) {
+    return sha256Digest(data.data(), data.size());
+}
+
+// Writes the 64 lowercase hex characters of a digest into out (no terminator)
+inline void digestToHex(const Digest& digest, char* out) {
+    static const char HEX[] = "0123456789abcdef";
+    for(size_t i = 0; i < digest.size(); i++) {
+        out[2 * i] = HEX[digest[i] >> 4];
+        out[2 * i + 1] = HEX[digest[i] & 0x0f];
+    }
+}
+
+inline std::string digestToHex(const Digest& digest) {
+    std::string out(2 * digest.size(), '0');
+    digestToHex(digest, &out[0]);
+    return out;
+}
+
+// For unordered containers keyed by digest: the bytes are already uniform
+struct DigestHasher {
+    size_t operator()(const Digest& digest) const {
+        size_t h;
+        std::memcpy(&h, digest.data(), sizeof(h));
+        return h;
+    }
+};
+
+inline int hexValue(char c) {
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Returns false if hex is not exactly 64 hex characters
+inline bool hexToDigest(const std::string& hex, Digest& out) {
+    if(hex.size() != 2 * out.size()) {
+        return false;
+    }
+    for(size_t i = 0; i < out.size(); i++) {
+        int hi = hexValue(hex[2 * i]);
+        int lo = hexValue(hex[2 * i + 1]);
+        if(hi < 0 || lo < 0) {
+            return false;
+        }
+        out[i] = (uint8_t)((hi << 4) | lo);
+    }
+    return true;
+}
+
+#endif //IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_DIGEST_H
@@ -0,0 +1,210 @@
+//
+// Created by abdelaziz on 10/17/2026.
+//
+
+#ifndef IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_ED25519_H
+#define IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_ED25519_H
+
+#include <array>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <cstdint>
+#include <cstring>
+#include <openssl/evp.h>
+#include "digest.h"
+#include "thread_pool.h"
+
+typedef std::array<uint8_t, 32> PublicKey;
+typedef std::array<uint8_t, 64> Signature;
+
+// Ed25519 key pair through OpenSSL's EVP interface. Copies share the key.
+class Ed25519Key {
+private:
+    std::shared_ptr<EVP_PKEY> key;
+
+    explicit Ed25519Key(EVP_PKEY* pkey) : key(pkey, EVP_PKEY_free) {}
+
+public:
+    Ed25519Key() {}
+
+    static Ed25519Key generate() {
+        EVP_PKEY* pkey = nullptr;
+        EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_ED25519, nullptr);
+        if(ctx != nullptr && EVP_PKEY_keygen_init(ctx) > 0) {
+            EVP_PKEY_keygen(ctx, &pkey);
+        }
+        EVP_PKEY_CTX_free(ctx);
+        return Ed25519Key(pkey);
+    }
+
+    // The same 32-byte seed always gives the same key
+    static Ed25519Key fromSeed(const Digest& seed) {
+        return Ed25519Key(EVP_PKEY_new_raw_private_key(EVP_PKEY_ED25519, nullptr, seed.data(), seed.size()));
+    }
+
+    bool isValid() const { return key != nullptr; }
+
+    PublicKey publicKey() const {
+        PublicKey out;
+        out.fill(0);
+        size_t length = out.size();
+        if(key) {
+            EVP_PKEY_get_raw_public_key(key.get(), out.data(), &length);
+        }
+        return out;
+    }
+
+    // All zero if the key is not valid
+    Signature sign(const uint8_t* message, size_t size) const {
+        Signature out;
+        out.fill(0);
+        size_t length = out.size();
+        EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+        if(key && ctx != nullptr && EVP_DigestSignInit(ctx, nullptr, nullptr, nullptr, key.get()) > 0) {
+            EVP_DigestSign(ctx, out.data(), &length, message, size);
+        }
+        EVP_MD_CTX_free(ctx);
+        return out;
+    }
+
+    Signature sign(const Digest& digest) const { return sign(digest.data(), digest.size()); }
+};
+
+inline bool ed25519Verify(const PublicKey& publicKey, const uint8_t* message, size_t size, const Signature& signature) {
+    EVP_PKEY* pkey = EVP_PKEY_new_raw_public_key(EVP_PKEY_ED25519, nullptr, publicKey.data(), publicKey.size());
+    EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+    bool valid = pkey != nullptr && ctx != nullptr
+                 && EVP_DigestVerifyInit(ctx, nullptr, nullptr, nullptr, pkey) > 0
+                 && EVP_DigestVerify(ctx, signature.data(), signature.size(), message, size) == 1;
+    EVP_MD_CTX_free(ctx);
+    EVP_PKEY_free(pkey);
+    return valid;
+}
+
+// One signature over a 32-byte message (a block hash)
+struct SignatureCheck {
+    PublicKey publicKey;
+    Digest message;
+    Signature signature;
+};
+
+// Checks batches of signatures on a thread pool and remembers the ones
+// that verified, so revalidating a chain only pays for new blocks. The
+// cache key is SHA256(key || message || signature): a changed byte
+// anywhere misses the cache and is verified again. Failures are never
+// cached. OpenSSL has no Ed25519 batch equation, so a batch is the
+// independent checks spread over the workers.
+class SignatureVerifier {
+private:
+    std::shared_ptr<ThreadPool> pool;
+    std::unordered_set<Digest, DigestHasher> verified;
+    size_t maxCached;
+    uint64_t cacheHits;
+    std::mutex mutex;
+
+    static Digest cacheKey(const SignatureCheck& check) {
+        uint8_t bytes[32 + 32 + 64];
+        std::memcpy(bytes, check.publicKey.data(), 32);
+        std::memcpy(bytes + 32, check.message.data(), 32);
+        std::memcpy(bytes + 64, check.signature.data(), 64);
+        return sha256Digest(bytes, sizeof(bytes));
+    }
+
+public:
+    // threads <= 1 verifies on the calling thread; the cache is emptied
+    // whenever it would exceed maxEntries
+    explicit SignatureVerifier(unsigned threads = 1, size_t maxEntries = 1 << 20)
+            : maxCached(maxEntries), cacheHits(0) {
+        setThreadCount(threads);
+    }
+
+    SignatureVerifier(const SignatureVerifier&) = delete;
+    SignatureVerifier& operator=(const SignatureVerifier&) = delete;
+
+    void setThreadCount(unsigned threads) {
+        if(threads <= 1) {
+            pool.reset();
+        } else {
+            pool = std::make_shared<ThreadPool>(threads);
+        }
+    }
+
+    // results, if given, gets one entry per check; returns true if all are valid
+    bool verifyBatch(const std::vector<SignatureCheck>& checks, std::vector<bool>* results = nullptr) {
+        std::vector<Digest> keys(checks.size());
+        std::vector<char> valid(checks.size(), 0);
+        std::vector<size_t> pending;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for(size_t i = 0; i < checks.size(); i++) {
+                keys[i] = cacheKey(checks[i]);
+                if(verified.count(keys[i])) {
+                    valid[i] = 1;
+                    cacheHits++;
+                } else {
+                    pending.push_back(i);
+                }
+            }
+        }
+
+        auto verifyPending = [&](size_t first, size_t step) {
+            for(size_t p = first; p < pending.size(); p += step) {
+                const SignatureCheck& check = checks[pending[p]];
+                valid[pending[p]] = ed25519Verify(check.publicKey, check.message.data(), check.message.size(),
+                                                  check.signature) ? 1 : 0;
+            }
+        };
+        if(pool && pending.size() > 1) {
+            size_t workers = pool->size();
+            pool->run(workers, [&](size_t worker) { verifyPending(worker, workers); });
+        } else {
+            verifyPending(0, 1);
+        }
+
+        bool allValid = true;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for(size_t p = 0; p < pending.size(); p++) {
+                if(valid[pending[p]]) {
+                    if(verified.size() >= maxCached) {
+                        verified.clear();
+                    }
+                    verified.insert(keys[pending[p]]);
+                }
+            }
+        }
+        if(results != nullptr) {
+            results->assign(checks.size(), false);
+        }
+        for(size_t i = 0; i < checks.size(); i++) {
+            allValid = allValid && valid[i];
+            if(results != nullptr) {
+                (*results)[i] = valid[i] != 0;
+            }
+        }
+        return allValid;
+    }
+
+    bool verify(const SignatureCheck& check) {
+        return verifyBatch(std::vector<SignatureCheck>(1, check));
+    }
+
+    size_t getCacheSize() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return verified.size();
+    }
+
+    uint64_t getCacheHits() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return cacheHits;
+    }
+
+    void clearCache() {
+        std::lock_guard<std::mutex> lock(mutex);
+        verified.clear();
+    }
+};
+
+#endif //IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_ED25519_H
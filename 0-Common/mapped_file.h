@@ -0,0 +1,91 @@
+//
+// Created by abdelaziz on 10/17/2026.
+//
+
+#ifndef IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_MAPPED_FILE_H
+#define IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_MAPPED_FILE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <fstream>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Read-only view of a whole file. Uses mmap where available, so the
+// pages are loaded on demand and dropped by the kernel under pressure;
+// elsewhere the file is read into memory.
+class MappedFile {
+private:
+    const uint8_t* bytes;
+    size_t length;
+    std::vector<uint8_t> fallback;
+
+public:
+    MappedFile() : bytes(nullptr), length(0) {}
+
+    ~MappedFile() {
+        close();
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path) {
+        close();
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if(fstat(fd, &info) != 0) {
+            ::close(fd);
+            return false;
+        }
+        length = (size_t)info.st_size;
+        if(length > 0) {
+            void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(mapped == MAP_FAILED) {
+                ::close(fd);
+                length = 0;
+                return false;
+            }
+            madvise(mapped, length, MADV_SEQUENTIAL);
+            bytes = (const uint8_t*)mapped;
+        }
+        ::close(fd);
+        return true;
+#else
+        std::ifstream in(path.c_str(), std::ios::binary);
+        if(!in) {
+            return false;
+        }
+        fallback.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        length = fallback.size();
+        bytes = fallback.empty() ? nullptr : fallback.data();
+        return true;
+#endif
+    }
+
+    void close() {
+#ifndef _WIN32
+        if(bytes != nullptr && fallback.empty()) {
+            munmap((void*)bytes, length);
+        }
+#endif
+        fallback.clear();
+        bytes = nullptr;
+        length = 0;
+    }
+
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+};
+
+#endif //IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_MAPPED_FILE_H
@@ -0,0 +1,466 @@
+//
+// Created by abdelaziz on 10/17/2026.
+//
+
+#ifndef IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_SHA256_MULTIBUFFER_H
+#define IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_SHA256_MULTIBUFFER_H
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "digest.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SHA256_MULTIBUFFER_X86 1
+#include <immintrin.h>
+#include <cpuid.h>
+#endif
+
+// SHA-256 of many independent messages at once. Equal-length messages are
+// hashed side by side in the 4, 8 or 16 lanes of SSE2, AVX2 or AVX-512
+// registers, or one after another with the SHA-NI instructions when the
+// CPU has them. The backend is picked at run time.
+enum Sha256Backend {
+    SHA256_BACKEND_SCALAR,
+    SHA256_BACKEND_SSE2,     // 4 lanes
+    SHA256_BACKEND_AVX2,     // 8 lanes
+    SHA256_BACKEND_AVX512,   // 16 lanes
+    SHA256_BACKEND_SHANI     // 1 lane, hardware rounds
+};
+
+static const uint32_t SHA256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const uint32_t SHA256_IV[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+#define SHA256_ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define SHA256_BSIG0(x) (SHA256_ROTR(x, 2) ^ SHA256_ROTR(x, 13) ^ SHA256_ROTR(x, 22))
+#define SHA256_BSIG1(x) (SHA256_ROTR(x, 6) ^ SHA256_ROTR(x, 11) ^ SHA256_ROTR(x, 25))
+#define SHA256_SSIG0(x) (SHA256_ROTR(x, 7) ^ SHA256_ROTR(x, 18) ^ ((x) >> 3))
+#define SHA256_SSIG1(x) (SHA256_ROTR(x, 17) ^ SHA256_ROTR(x, 19) ^ ((x) >> 10))
+
+inline uint32_t sha256LoadBE32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+inline void sha256StoreBE32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+inline void sha256CompressScalar(uint32_t state[8], const uint8_t* data, size_t blocks) {
+    uint32_t w[64];
+    for(; blocks > 0; blocks--, data += 64) {
+        for(int t = 0; t < 16; t++) {
+            w[t] = sha256LoadBE32(data + 4 * t);
+        }
+        for(int t = 16; t < 64; t++) {
+            w[t] = SHA256_SSIG1(w[t - 2]) + w[t - 7] + SHA256_SSIG0(w[t - 15]) + w[t - 16];
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for(int t = 0; t < 64; t++) {
+            uint32_t t1 = h + SHA256_BSIG1(e) + ((e & f) ^ (~e & g)) + SHA256_K[t] + w[t];
+            uint32_t t2 = SHA256_BSIG0(a) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+}
+
+#ifdef SHA256_MULTIBUFFER_X86
+
+typedef uint32_t Sha256Vec4 __attribute__((vector_size(16)));
+typedef uint32_t Sha256Vec8 __attribute__((vector_size(32)));
+typedef uint32_t Sha256Vec16 __attribute__((vector_size(64)));
+
+// One block per lane. state holds word i of lane l at state[i * LANES + l].
+// Inlined into the target-specific wrappers below, which pick the registers.
+template <typename V, size_t LANES>
+__attribute__((always_inline)) inline void sha256CompressLanes(uint32_t* state, const uint8_t* const* blocks) {
+    V w[16];
+    for(int t = 0; t < 16; t++) {
+        for(size_t l = 0; l < LANES; l++) {
+            w[t][l] = sha256LoadBE32(blocks[l] + 4 * t);
+        }
+    }
+
+    V s[8];
+    for(int i = 0; i < 8; i++) {
+        for(size_t l = 0; l < LANES; l++) {
+            s[i][l] = state[i * LANES + l];
+        }
+    }
+
+    V a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+    for(int t = 0; t < 64; t++) {
+        if(t >= 16) {
+            w[t & 15] += SHA256_SSIG1(w[(t - 2) & 15]) + w[(t - 7) & 15] + SHA256_SSIG0(w[(t - 15) & 15]);
+        }
+        V t1 = h + SHA256_BSIG1(e) + ((e & f) ^ (~e & g)) + SHA256_K[t] + w[t & 15];
+        V t2 = SHA256_BSIG0(a) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    s[0] += a; s[1] += b; s[2] += c; s[3] += d;
+    s[4] += e; s[5] += f; s[6] += g; s[7] += h;
+
+    for(int i = 0; i < 8; i++) {
+        for(size_t l = 0; l < LANES; l++) {
+            state[i * LANES + l] = s[i][l];
+        }
+    }
+}
+
+__attribute__((target("sse2")))
+inline void sha256CompressX4(uint32_t* state, const uint8_t* const* blocks) {
+    sha256CompressLanes<Sha256Vec4, 4>(state, blocks);
+}
+
+__attribute__((target("avx2")))
+inline void sha256CompressX8(uint32_t* state, const uint8_t* const* blocks) {
+    sha256CompressLanes<Sha256Vec8, 8>(state, blocks);
+}
+
+__attribute__((target("avx512f")))
+inline void sha256CompressX16(uint32_t* state, const uint8_t* const* blocks) {
+    sha256CompressLanes<Sha256Vec16, 16>(state, blocks);
+}
+
+// Hardware rounds: two rounds per sha256rnds2, message schedule with
+// sha256msg1/sha256msg2. State is kept as ABEF / CDGH register pairs.
+__attribute__((target("sha,sse4.1")))
+inline void sha256CompressShaNi(uint32_t state[8], const uint8_t* data, size_t blocks) {
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    __m128i tmp = _mm_loadu_si128((const __m128i*)&state[0]);
+    __m128i state1 = _mm_loadu_si128((const __m128i*)&state[4]);
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);
+    state1 = _mm_shuffle_epi32(state1, 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    for(; blocks > 0; blocks--, data += 64) {
+        __m128i abefSave = state0;
+        __m128i cdghSave = state1;
+        __m128i w[4];
+
+        for(int g = 0; g < 16; g++) {
+            if(g < 4) {
+                w[g] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 16 * g)), byteSwap);
+            }
+            __m128i msg = _mm_add_epi32(w[g & 3], _mm_loadu_si128((const __m128i*)&SHA256_K[4 * g]));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+            if(g >= 3 && g <= 14) {
+                __m128i next = _mm_add_epi32(w[(g + 1) & 3], _mm_alignr_epi8(w[g & 3], w[(g + 3) & 3], 4));
+                w[(g + 1) & 3] = _mm_sha256msg2_epu32(next, w[g & 3]);
+            }
+            msg = _mm_shuffle_epi32(msg, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+            if(g >= 1 && g <= 12) {
+                w[(g + 3) & 3] = _mm_sha256msg1_epu32(w[(g + 3) & 3], w[g & 3]);
+            }
+        }
+
+        state0 = _mm_add_epi32(state0, abefSave);
+        state1 = _mm_add_epi32(state1, cdghSave);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+    _mm_storeu_si128((__m128i*)&state[0], state0);
+    _mm_storeu_si128((__m128i*)&state[4], state1);
+}
+
+inline bool sha256CpuHasShaNi() {
+    unsigned int eax, ebx, ecx, edx;
+    if(!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    // SHA-NI also needs SSE4.1 for the blend and the byte shuffle
+    return (ebx & (1u << 29)) != 0 && __builtin_cpu_supports("sse4.1");
+}
+
+#endif // SHA256_MULTIBUFFER_X86
+
+inline bool sha256BackendSupported(Sha256Backend backend) {
+#ifdef SHA256_MULTIBUFFER_X86
+    switch(backend) {
+        case SHA256_BACKEND_SCALAR: return true;
+        case SHA256_BACKEND_SSE2:   return __builtin_cpu_supports("sse2");
+        case SHA256_BACKEND_AVX2:   return __builtin_cpu_supports("avx2");
+        case SHA256_BACKEND_AVX512: return __builtin_cpu_supports("avx512f");
+        case SHA256_BACKEND_SHANI:  return sha256CpuHasShaNi();
+    }
+    return false;
+#else
+    return backend == SHA256_BACKEND_SCALAR;
+#endif
+}
+
+inline Sha256Backend sha256DetectBackend() {
+    static const Sha256Backend preferred[] = {
+        SHA256_BACKEND_SHANI, SHA256_BACKEND_AVX512, SHA256_BACKEND_AVX2, SHA256_BACKEND_SSE2
+    };
+    for(Sha256Backend backend : preferred) {
+        if(sha256BackendSupported(backend)) {
+            return backend;
+        }
+    }
+    return SHA256_BACKEND_SCALAR;
+}
+
+// Backend used when none is passed explicitly; detected once
+inline Sha256Backend& sha256ActiveBackend() {
+    static Sha256Backend active = sha256DetectBackend();
+    return active;
+}
+
+// Returns false, and changes nothing, if the CPU lacks the backend
+inline bool setSha256Backend(Sha256Backend backend) {
+    if(!sha256BackendSupported(backend)) {
+        return false;
+    }
+    sha256ActiveBackend() = backend;
+    return true;
+}
+
+inline const char* sha256BackendName(Sha256Backend backend) {
+    switch(backend) {
+        case SHA256_BACKEND_SCALAR: return "scalar";
+        case SHA256_BACKEND_SSE2:   return "sse2 x4";
+        case SHA256_BACKEND_AVX2:   return "avx2 x8";
+        case SHA256_BACKEND_AVX512: return "avx512 x16";
+        case SHA256_BACKEND_SHANI:  return "sha-ni";
+    }
+    return "unknown";
+}
+
+inline size_t sha256BackendLanes(Sha256Backend backend) {
+    switch(backend) {
+        case SHA256_BACKEND_SSE2:   return 4;
+        case SHA256_BACKEND_AVX2:   return 8;
+        case SHA256_BACKEND_AVX512: return 16;
+        default:                    return 1;
+    }
+}
+
+// Compresses whole 64-byte blocks of a single message into state
+inline void sha256CompressBlocks(uint32_t state[8], const uint8_t* data, size_t blocks,
+                                 Sha256Backend backend = sha256ActiveBackend()) {
+#ifdef SHA256_MULTIBUFFER_X86
+    if(backend == SHA256_BACKEND_SHANI) {
+        sha256CompressShaNi(state, data, blocks);
+        return;
+    }
+#endif
+    (void)backend;
+    sha256CompressScalar(state, data, blocks);
+}
+
+// Final digests of count messages already padded to blocks * 64 bytes
+// (0x80, zeros, bit length), all continuing from initialState
+inline void sha256FinishPadded(const uint32_t initialState[8], const uint8_t* const* padded,
+                               size_t blocks, size_t count, Digest* out,
+                               Sha256Backend backend = sha256ActiveBackend()) {
+    size_t lanes = sha256BackendLanes(backend);
+    uint32_t state[8 * 16];
+    const uint8_t* lanePointers[16];
+
+    for(size_t first = 0; first < count; first += lanes) {
+        size_t used = std::min(lanes, count - first);
+
+        if(lanes == 1) {
+            uint32_t single[8];
+            std::memcpy(single, initialState, sizeof(single));
+            sha256CompressBlocks(single, padded[first], blocks, backend);
+            for(int i = 0; i < 8; i++) {
+                sha256StoreBE32(out[first].data() + 4 * i, single[i]);
+            }
+            continue;
+        }
+
+#ifdef SHA256_MULTIBUFFER_X86
+        for(int i = 0; i < 8; i++) {
+            for(size_t l = 0; l < lanes; l++) {
+                state[i * lanes + l] = initialState[i];
+            }
+        }
+
+        // Unused lanes repeat lane 0 and are discarded
+        for(size_t b = 0; b < blocks; b++) {
+            for(size_t l = 0; l < lanes; l++) {
+                lanePointers[l] = padded[first + ((l < used) ? l : 0)] + 64 * b;
+            }
+            if(lanes == 4) {
+                sha256CompressX4(state, lanePointers);
+            } else if(lanes == 8) {
+                sha256CompressX8(state, lanePointers);
+            } else {
+                sha256CompressX16(state, lanePointers);
+            }
+        }
+
+        for(size_t l = 0; l < used; l++) {
+            for(int i = 0; i < 8; i++) {
+                sha256StoreBE32(out[first + l].data() + 4 * i, state[i * lanes + l]);
+            }
+        }
+#else
+        (void)state;
+        (void)lanePointers;
+#endif
+    }
+}
+
+// Number of 64-byte blocks of a tailLength-byte message once padded
+inline size_t sha256PaddedBlocks(size_t tailLength) {
+    return (tailLength + 9 + 63) / 64;
+}
+
+// Writes the SHA-256 padding after tailLength bytes of buffer, which must
+// hold sha256PaddedBlocks(tailLength) * 64 bytes. totalLength counts every
+// byte of the message, including those already absorbed in a midstate.
+inline void sha256WritePadding(uint8_t* buffer, size_t tailLength, uint64_t totalLength) {
+    size_t end = sha256PaddedBlocks(tailLength) * 64;
+    std::memset(buffer + tailLength, 0, end - tailLength);
+    buffer[tailLength] = 0x80;
+    for(int i = 0; i < 8; i++) {
+        buffer[end - 1 - i] = (uint8_t)((totalLength * 8) >> (8 * i));
+    }
+}
+
+// Hashes count messages that all continue from the same state. Each
+// message i is tails[i] (tailLength bytes) appended to prefixLength bytes
+// already absorbed in initialState; prefixLength must be a multiple of 64.
+// Use SHA256_IV and prefixLength = 0 for plain messages.
+inline void sha256BatchFromState(const uint32_t initialState[8], uint64_t prefixLength,
+                                 const uint8_t* const* tails, size_t tailLength, size_t count,
+                                 Digest* out, Sha256Backend backend = sha256ActiveBackend()) {
+    const size_t fullBlocks = tailLength / 64;
+    const size_t rest = tailLength % 64;
+    const size_t paddingBlocks = (rest + 9 <= 64) ? 1 : 2;
+    const uint64_t bitLength = (prefixLength + tailLength) * 8;
+
+    size_t lanes = sha256BackendLanes(backend);
+    uint8_t padding[16][128];
+    uint32_t state[8 * 16];
+    const uint8_t* blocks[16];
+
+    for(size_t first = 0; first < count; first += lanes) {
+        size_t used = std::min(lanes, count - first);
+
+        // Final one or two blocks of every lane: leftover bytes, 0x80, zeros, bit length
+        for(size_t l = 0; l < used; l++) {
+            uint8_t* pad = padding[l];
+            std::memset(pad, 0, 64 * paddingBlocks);
+            std::memcpy(pad, tails[first + l] + fullBlocks * 64, rest);
+            pad[rest] = 0x80;
+            for(int i = 0; i < 8; i++) {
+                pad[64 * paddingBlocks - 1 - i] = (uint8_t)(bitLength >> (8 * i));
+            }
+        }
+
+        if(lanes == 1) {
+            uint32_t single[8];
+            std::memcpy(single, initialState, sizeof(single));
+            sha256CompressBlocks(single, tails[first], fullBlocks, backend);
+            sha256CompressBlocks(single, padding[0], paddingBlocks, backend);
+            for(int i = 0; i < 8; i++) {
+                sha256StoreBE32(out[first].data() + 4 * i, single[i]);
+            }
+            continue;
+        }
+
+#ifdef SHA256_MULTIBUFFER_X86
+        for(int i = 0; i < 8; i++) {
+            for(size_t l = 0; l < lanes; l++) {
+                state[i * lanes + l] = initialState[i];
+            }
+        }
+
+        // Unused lanes repeat lane 0 and are discarded
+        for(size_t b = 0; b < fullBlocks + paddingBlocks; b++) {
+            for(size_t l = 0; l < lanes; l++) {
+                size_t source = (l < used) ? l : 0;
+                blocks[l] = (b < fullBlocks) ? tails[first + source] + 64 * b
+                                             : padding[source] + 64 * (b - fullBlocks);
+            }
+            if(lanes == 4) {
+                sha256CompressX4(state, blocks);
+            } else if(lanes == 8) {
+                sha256CompressX8(state, blocks);
+            } else {
+                sha256CompressX16(state, blocks);
+            }
+        }
+
+        for(size_t l = 0; l < used; l++) {
+            for(int i = 0; i < 8; i++) {
+                sha256StoreBE32(out[first + l].data() + 4 * i, state[i * lanes + l]);
+            }
+        }
+#else
+        (void)state;
+        (void)blocks;
+#endif
+    }
+}
+
+// Hashes count messages of the same length
+inline void sha256Batch(const uint8_t* const* messages, size_t length, size_t count, Digest* out,
+                        Sha256Backend backend = sha256ActiveBackend()) {
+    sha256BatchFromState(SHA256_IV, 0, messages, length, count, out, backend);
+}
+
+// Hashes strings of any length; strings of equal length share a batch
+inline void sha256BatchStrings(const std::vector<std::string>& messages, Digest* out,
+                               Sha256Backend backend = sha256ActiveBackend()) {
+    std::vector<size_t> order(messages.size());
+    for(size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&messages](size_t x, size_t y) {
+        return messages[x].size() < messages[y].size();
+    });
+
+    std::vector<const uint8_t*> pointers;
+    std::vector<Digest> digests;
+    for(size_t begin = 0; begin < order.size();) {
+        size_t length = messages[order[begin]].size();
+        size_t end = begin;
+        pointers.clear();
+        while(end < order.size() && messages[order[end]].size() == length) {
+            pointers.push_back((const uint8_t*)messages[order[end]].data());
+            end++;
+        }
+
+        digests.resize(pointers.size());
+        sha256Batch(pointers.data(), length, pointers.size(), digests.data(), backend);
+        for(size_t i = begin; i < end; i++) {
+            out[order[i]] = digests[i - begin];
+        }
+        begin = end;
+    }
+}
+
+#endif //IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_SHA256_MULTIBUFFER_H
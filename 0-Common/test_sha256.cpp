@@ -0,0 +1,73 @@
+//
+// Created by abdelaziz on 10/17/2026.
+//
+
+#include "sha256_multibuffer.h"
+#include <iostream>
+#include <sstream>
+
+// Compares every available backend with OpenSSL SHA256()
+int main() {
+    std::cout << "=== Test SHA-256 multi-buffer ===" << std::endl;
+    std::cout << "Backend detecte: " << sha256BackendName(sha256DetectBackend()) << std::endl << std::endl;
+
+    Sha256Backend backends[] = {
+        SHA256_BACKEND_SCALAR, SHA256_BACKEND_SSE2, SHA256_BACKEND_AVX2,
+        SHA256_BACKEND_AVX512, SHA256_BACKEND_SHANI
+    };
+
+    bool allOk = true;
+    for(Sha256Backend backend : backends) {
+        if(!sha256BackendSupported(backend)) {
+            std::cout << sha256BackendName(backend) << ": non supporte" << std::endl;
+            continue;
+        }
+
+        bool ok = true;
+        for(size_t length = 0; length <= 200 && ok; length++) {
+            for(size_t count = 1; count <= 19 && ok; count += 3) {
+                std::vector<std::string> messages;
+                std::vector<const uint8_t*> pointers;
+                for(size_t i = 0; i < count; i++) {
+                    std::string message(length, '\0');
+                    for(size_t j = 0; j < length; j++) {
+                        message[j] = (char)((i * 131 + j * 7 + length) & 0xff);
+                    }
+                    messages.push_back(message);
+                }
+                for(const auto& m : messages) {
+                    pointers.push_back((const uint8_t*)m.data());
+                }
+
+                std::vector<Digest> digests(count);
+                sha256Batch(pointers.data(), length, count, digests.data(), backend);
+                for(size_t i = 0; i < count; i++) {
+                    if(digests[i] != sha256Digest(messages[i])) {
+                        ok = false;
+                    }
+                }
+            }
+        }
+
+        std::vector<std::string> mixed;
+        for(int i = 0; i < 50; i++) {
+            std::stringstream ss;
+            ss << "Transaction " << i * i * i;
+            mixed.push_back(ss.str());
+        }
+        std::vector<Digest> mixedDigests(mixed.size());
+        sha256BatchStrings(mixed, mixedDigests.data(), backend);
+        for(size_t i = 0; i < mixed.size(); i++) {
+            if(mixedDigests[i] != sha256Digest(mixed[i])) {
+                ok = false;
+            }
+        }
+
+        std::cout << sha256BackendName(backend) << ": "
+                  << (ok ? "identique a OpenSSL" : "DIFFERENT d'OpenSSL") << std::endl;
+        allOk = allOk && ok;
+    }
+
+    std::cout << std::endl << "Tous les backends corrects: " << (allOk ? "OUI" : "NON") << std::endl;
+    return allOk ? 0 : 1;
+}
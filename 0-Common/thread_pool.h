@@ -0,0 +1,104 @@
+//
+// Created by abdelaziz on 10/17/2026.
+//
+
+#ifndef IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_THREAD_POOL_H
+#define IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_THREAD_POOL_H
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// Fixed set of worker threads fed from a task queue
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()> > tasks;
+    std::mutex mutex;
+    std::condition_variable available;
+    bool stopping;
+
+    void workerLoop() {
+        while(true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                available.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if(tasks.empty()) {
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+            task();
+        }
+    }
+
+public:
+    // threads = 0 uses one worker per hardware thread
+    explicit ThreadPool(unsigned threads = 0) : stopping(false) {
+        if(threads == 0) {
+            threads = std::thread::hardware_concurrency();
+        }
+        if(threads == 0) {
+            threads = 1;
+        }
+        for(unsigned i = 0; i < threads; i++) {
+            workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        available.notify_all();
+        for(auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push(std::move(task));
+        }
+        available.notify_one();
+    }
+
+    // Calls fn(task) for every task in [0, taskCount) on the workers and
+    // returns once all of them are done
+    void run(size_t taskCount, const std::function<void(size_t)>& fn) {
+        if(taskCount == 0) {
+            return;
+        }
+
+        std::mutex doneMutex;
+        std::condition_variable done;
+        size_t remaining = taskCount;
+
+        for(size_t t = 0; t < taskCount; t++) {
+            submit([&fn, &doneMutex, &done, &remaining, t] {
+                fn(t);
+                std::lock_guard<std::mutex> lock(doneMutex);
+                if(--remaining == 0) {
+                    done.notify_all();
+                }
+            });
+        }
+
+        std::unique_lock<std::mutex> lock(doneMutex);
+        done.wait(lock, [&remaining] { return remaining == 0; });
+    }
+
+    size_t size() const { return workers.size(); }
+};
+
+#endif //IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_THREAD_POOL_H
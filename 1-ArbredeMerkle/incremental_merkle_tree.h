@@ -0,0 +1,94 @@
+//
+// Created by abdelaziz on 10/17/2026.
+//
+
+#ifndef IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_INCREMENTAL_MERKLE_TREE_H
+#define IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_INCREMENTAL_MERKLE_TREE_H
+
+#include <string>
+#include <vector>
+#include "merkle_tree.h"
+#include "merkle_proof.h"
+
+// Merkle tree that keeps every level, so appending or replacing a
+// transaction only rehashes its path to the root.
+// Roots are identical to MerkleTree::getMerkleRoot in the same mode.
+class IncrementalMerkleTree {
+private:
+    MerkleHashMode mode;
+    // levels[0] holds the leaf digests, levels.back() the root
+    MerkleLevels levels;
+
+    // Recomputes the ancestors of leaf index, adding a level when the top grows
+    void updatePath(size_t index) {
+        for(size_t level = 0; levels[level].size() > 1; level++) {
+            if(level + 1 == levels.size()) {
+                levels.push_back(std::vector<Digest>());
+            }
+
+            const std::vector<Digest>& current = levels[level];
+            size_t left = index & ~(size_t)1;
+            const Digest& right = (left + 1 < current.size()) ? current[left + 1] : current[left];
+            Digest parent = MerkleTree::combineDigests(current[left], right, mode);
+
+            index /= 2;
+            std::vector<Digest>& next = levels[level + 1];
+            if(index < next.size()) {
+                next[index] = parent;
+            } else {
+                next.push_back(parent);
+            }
+        }
+    }
+
+public:
+    IncrementalMerkleTree(MerkleHashMode hashMode = MERKLE_HEX_COMPAT)
+            : mode(hashMode), levels(1) {}
+
+    IncrementalMerkleTree(const std::vector<std::string>& transactions,
+                          MerkleHashMode hashMode = MERKLE_HEX_COMPAT)
+            : mode(hashMode), levels(buildMerkleLevels(transactions, hashMode)) {}
+
+    // Adds a transaction at the end, O(log n) hashes
+    void append(const std::string& tx) {
+        levels[0].push_back(MerkleTree::hashLeaf(tx));
+        updatePath(levels[0].size() - 1);
+    }
+
+    // Replaces transaction i, O(log n) hashes. Returns false if i is out of range.
+    bool update(size_t i, const std::string& tx) {
+        if(i >= levels[0].size()) {
+            return false;
+        }
+        levels[0][i] = MerkleTree::hashLeaf(tx);
+        updatePath(i);
+        return true;
+    }
+
+    Digest getRootDigest() const {
+        if(levels[0].empty()) {
+            return MerkleTree::hashLeaf("");
+        }
+        return levels.back()[0];
+    }
+
+    std::string getRoot() const {
+        return digestToHex(getRootDigest());
+    }
+
+    // Authentication path of transaction i, read from the cached levels
+    MerkleProof getProof(size_t i) const {
+        return makeMerkleProof(levels, i);
+    }
+
+    MerkleMultiProof getMultiProof(const std::vector<size_t>& indices) const {
+        return makeMerkleMultiProof(levels, indices);
+    }
+
+    size_t size() const { return levels[0].size(); }
+    MerkleHashMode getHashMode() const { return mode; }
+    const MerkleLevels& getLevels() const { return levels; }
+};
+
+
+#endif //IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_INCREMENTAL_MERKLE_TREE_H
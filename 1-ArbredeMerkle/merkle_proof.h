@@ -0,0 +1,265 @@
+//
+// Created by abdelaziz on 10/17/2026.
+//
+
+#ifndef IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_MERKLE_PROOF_H
+#define IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_MERKLE_PROOF_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+#include <algorithm>
+#include "merkle_tree.h"
+
+typedef std::vector<std::vector<Digest> > MerkleLevels;
+
+// Authentication path of one leaf, from the leaf level up to the root.
+// A lone last node is paired with itself, so no sibling is stored for it.
+struct MerkleProof {
+    size_t leafIndex;
+    size_t leafCount;
+    std::vector<Digest> siblings;
+
+    MerkleProof() : leafIndex(0), leafCount(0) {}
+};
+
+// Proof for several leaves at once. Siblings shared by the paths or
+// computable from other proven leaves are not repeated.
+struct MerkleMultiProof {
+    size_t leafCount;
+    std::vector<size_t> indices;   // sorted, without duplicates
+    std::vector<Digest> hashes;    // missing siblings, level by level, left to right
+
+    MerkleMultiProof() : leafCount(0) {}
+};
+
+// Builds every level above the given leaf digests (levels[0] = leaves)
+inline MerkleLevels buildMerkleLevels(const std::vector<Digest>& leaves, MerkleHashMode mode) {
+    MerkleLevels levels(1, leaves);
+    while(levels.back().size() > 1) {
+        const std::vector<Digest>& current = levels.back();
+        std::vector<Digest> next;
+        next.reserve((current.size() + 1) / 2);
+        for(size_t i = 0; i < current.size(); i += 2) {
+            const Digest& right = (i + 1 < current.size()) ? current[i + 1] : current[i];
+            next.push_back(MerkleTree::combineDigests(current[i], right, mode));
+        }
+        levels.push_back(next);
+    }
+    return levels;
+}
+
+inline MerkleLevels buildMerkleLevels(const std::vector<std::string>& transactions, MerkleHashMode mode) {
+    std::vector<Digest> leaves;
+    leaves.reserve(transactions.size());
+    for(const auto& tx : transactions) {
+        leaves.push_back(MerkleTree::hashLeaf(tx));
+    }
+    return buildMerkleLevels(leaves, mode);
+}
+
+inline MerkleProof makeMerkleProof(const MerkleLevels& levels, size_t leafIndex) {
+    MerkleProof proof;
+    proof.leafIndex = leafIndex;
+    proof.leafCount = levels[0].size();
+
+    size_t index = leafIndex;
+    for(size_t level = 0; level + 1 < levels.size(); level++) {
+        size_t sibling = index ^ 1;
+        if(sibling < levels[level].size()) {
+            proof.siblings.push_back(levels[level][sibling]);
+        }
+        index /= 2;
+    }
+    return proof;
+}
+
+// Walks the path of one proof. Calls visit(level, index, digest) for every
+// node computed above the leaf; visit returns true to stop early.
+template <typename Visitor>
+inline bool walkMerkleProof(const Digest& leaf, const MerkleProof& proof,
+                            MerkleHashMode mode, Digest& node, Visitor visit) {
+    if(proof.leafIndex >= proof.leafCount) {
+        return false;
+    }
+
+    node = leaf;
+    size_t index = proof.leafIndex;
+    size_t count = proof.leafCount;
+    size_t used = 0;
+
+    for(size_t level = 0; count > 1; level++) {
+        if(index & 1) {
+            if(used == proof.siblings.size()) return false;
+            node = MerkleTree::combineDigests(proof.siblings[used++], node, mode);
+        } else if(index + 1 < count) {
+            if(used == proof.siblings.size()) return false;
+            node = MerkleTree::combineDigests(node, proof.siblings[used++], mode);
+        } else {
+            node = MerkleTree::combineDigests(node, node, mode);
+        }
+        index /= 2;
+        count = (count + 1) / 2;
+
+        if(visit(level + 1, index, node)) {
+            return true;
+        }
+    }
+    return used == proof.siblings.size();
+}
+
+struct NoMerkleVisit {
+    bool operator()(size_t, size_t, const Digest&) const { return false; }
+};
+
+inline bool verifyMerkleProof(const Digest& leaf, const MerkleProof& proof,
+                              const Digest& root, MerkleHashMode mode = MERKLE_HEX_COMPAT) {
+    Digest node;
+    return walkMerkleProof(leaf, proof, mode, node, NoMerkleVisit()) && node == root;
+}
+
+typedef std::map<std::pair<size_t, size_t>, Digest> VerifiedMerkleNodes;
+
+// Records the nodes of a path and stops as soon as the path reaches a node
+// already authenticated against the root by an earlier proof.
+struct MerklePathRecorder {
+    const VerifiedMerkleNodes* verified;
+    std::vector<std::pair<std::pair<size_t, size_t>, Digest> >* path;
+    bool* joined;
+
+    bool operator()(size_t level, size_t index, const Digest& node) const {
+        std::pair<size_t, size_t> key(level, index);
+        VerifiedMerkleNodes::const_iterator it = verified->find(key);
+        if(it != verified->end()) {
+            *joined = (it->second == node);
+            return true;
+        }
+        path->push_back(std::make_pair(key, node));
+        return false;
+    }
+};
+
+// Verifies many proofs against the same root. Paths share their upper
+// nodes, so each proof stops hashing where it meets an already verified
+// node. results[i] tells whether proof i is valid; returns true if all are.
+inline bool verifyMerkleProofs(const std::vector<Digest>& leaves,
+                               const std::vector<MerkleProof>& proofs,
+                               const Digest& root,
+                               std::vector<bool>& results,
+                               MerkleHashMode mode = MERKLE_HEX_COMPAT) {
+    results.assign(proofs.size(), false);
+    if(leaves.size() != proofs.size()) {
+        return false;
+    }
+
+    // Node positions only mean something for a given leaf count
+    std::map<size_t, VerifiedMerkleNodes> verified;
+    std::vector<std::pair<std::pair<size_t, size_t>, Digest> > path;
+    bool allValid = true;
+
+    for(size_t i = 0; i < proofs.size(); i++) {
+        VerifiedMerkleNodes& nodes = verified[proofs[i].leafCount];
+        path.clear();
+        bool joined = false;
+        MerklePathRecorder recorder = {&nodes, &path, &joined};
+
+        Digest node;
+        bool complete = walkMerkleProof(leaves[i], proofs[i], mode, node, recorder);
+        bool valid = complete && (joined || (path.empty() ? leaves[i] == root : node == root));
+
+        if(valid) {
+            nodes.insert(path.begin(), path.end());
+        }
+        results[i] = valid;
+        allValid = allValid && valid;
+    }
+    return allValid;
+}
+
+// Indices past the last leaf are dropped
+inline MerkleMultiProof makeMerkleMultiProof(const MerkleLevels& levels, std::vector<size_t> indices) {
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+    indices.erase(std::lower_bound(indices.begin(), indices.end(), levels[0].size()), indices.end());
+
+    MerkleMultiProof proof;
+    proof.leafCount = levels[0].size();
+    proof.indices = indices;
+
+    std::vector<size_t> known = indices;
+    for(size_t level = 0; level + 1 < levels.size(); level++) {
+        const std::vector<Digest>& current = levels[level];
+        std::vector<size_t> parents;
+
+        for(size_t j = 0; j < known.size(); j++) {
+            size_t index = known[j];
+            if(index & 1) {
+                proof.hashes.push_back(current[index - 1]);
+            } else if(index + 1 < current.size()) {
+                if(j + 1 < known.size() && known[j + 1] == index + 1) {
+                    j++;
+                } else {
+                    proof.hashes.push_back(current[index + 1]);
+                }
+            }
+            parents.push_back(index / 2);
+        }
+        known.swap(parents);
+    }
+    return proof;
+}
+
+// leaves[i] is the digest of leaf proof.indices[i]
+inline bool verifyMerkleMultiProof(const std::vector<Digest>& leaves,
+                                   const MerkleMultiProof& proof,
+                                   const Digest& root,
+                                   MerkleHashMode mode = MERKLE_HEX_COMPAT) {
+    if(leaves.size() != proof.indices.size() || leaves.empty()) {
+        return false;
+    }
+    for(size_t j = 0; j < proof.indices.size(); j++) {
+        if(proof.indices[j] >= proof.leafCount || (j > 0 && proof.indices[j] <= proof.indices[j - 1])) {
+            return false;
+        }
+    }
+
+    std::vector<size_t> known = proof.indices;
+    std::vector<Digest> nodes = leaves;
+    size_t count = proof.leafCount;
+    size_t used = 0;
+
+    while(count > 1) {
+        std::vector<size_t> parents;
+        std::vector<Digest> parentNodes;
+
+        for(size_t j = 0; j < known.size(); j++) {
+            size_t index = known[j];
+            Digest parent;
+            if(index & 1) {
+                if(used == proof.hashes.size()) return false;
+                parent = MerkleTree::combineDigests(proof.hashes[used++], nodes[j], mode);
+            } else if(index + 1 < count) {
+                if(j + 1 < known.size() && known[j + 1] == index + 1) {
+                    parent = MerkleTree::combineDigests(nodes[j], nodes[j + 1], mode);
+                    j++;
+                } else {
+                    if(used == proof.hashes.size()) return false;
+                    parent = MerkleTree::combineDigests(nodes[j], proof.hashes[used++], mode);
+                }
+            } else {
+                parent = MerkleTree::combineDigests(nodes[j], nodes[j], mode);
+            }
+            parents.push_back(index / 2);
+            parentNodes.push_back(parent);
+        }
+
+        known.swap(parents);
+        nodes.swap(parentNodes);
+        count = (count + 1) / 2;
+    }
+    return used == proof.hashes.size() && nodes[0] == root;
+}
+
+
+#endif //IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_MERKLE_PROOF_H
@@ -0,0 +1,57 @@
+//
+// Created by abdelaziz on 10/17/2026.
+//
+
+#include "merkle_tree.h"
+#include "parallel_merkle_tree.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <chrono>
+#include <thread>
+
+// Roots per second of ParallelMerkleTree for several thread and leaf counts
+int main() {
+    std::vector<size_t> leafCounts = {1000, 10000, 100000, 1000000};
+    std::vector<unsigned> threadCounts = {1, 2, 4, 8};
+
+    std::vector<std::string> transactions;
+    for(size_t i = 0; i < leafCounts.back(); i++) {
+        std::stringstream ss;
+        ss << "TX" << i << " Alice sends " << i % 97 << " BTC to Bob";
+        transactions.push_back(ss.str());
+    }
+
+    std::cout << "Hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+    std::cout << std::left << std::setw(12) << "Leaves" << std::setw(10) << "Threads"
+              << std::setw(16) << "Roots/s" << std::setw(12) << "Speedup" << std::endl;
+    std::cout << std::string(50, '-') << std::endl;
+
+    for(size_t leaves : leafCounts) {
+        std::vector<std::string> txs(transactions.begin(), transactions.begin() + leaves);
+        double serialRate = 0;
+
+        for(unsigned threads : threadCounts) {
+            ParallelMerkleTree tree(threads);
+            tree.getMerkleRootDigest(txs);
+
+            int roots = 0;
+            auto start = std::chrono::steady_clock::now();
+            std::chrono::duration<double> elapsed(0);
+            while(elapsed.count() < 0.5 || roots < 3) {
+                tree.getMerkleRootDigest(txs);
+                roots++;
+                elapsed = std::chrono::steady_clock::now() - start;
+            }
+
+            double rate = roots / elapsed.count();
+            if(threads == 1) {
+                serialRate = rate;
+            }
+            std::cout << std::left << std::setw(12) << leaves << std::setw(10) << threads
+                      << std::setw(16) << std::fixed << std::setprecision(2) << rate
+                      << std::setw(12) << rate / serialRate << std::endl;
+        }
+    }
+    return 0;
+}
@@ -3,7 +3,13 @@
 //
 
 #include "merkle_tree.h"
+#include "incremental_merkle_tree.h"
+#include "parallel_merkle_tree.h"
+#include "streaming_merkle_root.h"
+#include <fstream>
+#include <cstdio>
 #include <iostream>
+#include <sstream>
 
 int main() {
     MerkleTree tree;
@@ -42,7 +48,126 @@ int main() {
     transactions1[0] = "Alice sends 11 BTC to Bob";
     std::string root4b = tree.getMerkleRoot(transactions1);
     std::cout << "Root modifie: " << root4b << std::endl;
-    std::cout << "Les roots sont differents: " << (root4a != root4b ? "OUI" : "NON") << std::endl;
+    std::cout << "Les roots sont differents: " << (root4a != root4b ? "OUI" : "NON") << std::endl << std::endl;
+
+    std::cout << "=== Test 5: Mode binaire vs mode compatible ===" << std::endl;
+    transactions1[0] = "Alice sends 10 BTC to Bob";
+    MerkleTree binaryTree(MERKLE_BINARY);
+    std::string rootBinary = binaryTree.getMerkleRoot(transactions1);
+    std::cout << "Root binaire: " << rootBinary << std::endl;
+    std::cout << "Root compatible identique a l'original: "
+              << (tree.getMerkleRoot(transactions1) == root4a ? "OUI" : "NON") << std::endl;
+    std::cout << "Les deux modes different: " << (rootBinary != root4a ? "OUI" : "NON") << std::endl << std::endl;
+
+    std::cout << "=== Test 6: Arbre incremental (append / update) ===" << std::endl;
+    IncrementalMerkleTree incremental;
+    std::vector<std::string> added;
+    bool appendOk = true;
+    for(int i = 0; i < 33; i++) {
+        std::stringstream ss;
+        ss << "Transaction " << i;
+        added.push_back(ss.str());
+        incremental.append(ss.str());
+        if(incremental.getRoot() != tree.getMerkleRoot(added)) {
+            appendOk = false;
+        }
+    }
+    std::cout << "Roots identiques apres chaque append: " << (appendOk ? "OUI" : "NON") << std::endl;
+
+    added[17] = "Transaction 17 modifiee";
+    incremental.update(17, added[17]);
+    std::cout << "Root identique apres update: "
+              << (incremental.getRoot() == tree.getMerkleRoot(added) ? "OUI" : "NON") << std::endl << std::endl;
+
+    std::cout << "=== Test 7: Preuves d'inclusion ===" << std::endl;
+    bool proofsOk = true;
+    for(size_t n = 1; n <= 20; n++) {
+        std::vector<std::string> txs(added.begin(), added.begin() + n);
+        IncrementalMerkleTree proofTree(txs);
+        Digest root = proofTree.getRootDigest();
+
+        std::vector<Digest> leaves;
+        std::vector<MerkleProof> proofs;
+        std::vector<size_t> evenIndices;
+        std::vector<Digest> evenLeaves;
+        for(size_t i = 0; i < n; i++) {
+            leaves.push_back(MerkleTree::hashLeaf(txs[i]));
+            proofs.push_back(proofTree.getProof(i));
+            if(i % 2 == 0 || i + 1 == n) {
+                evenIndices.push_back(i);
+                evenLeaves.push_back(leaves.back());
+            }
+        }
+
+        std::vector<bool> results;
+        proofsOk = proofsOk && verifyMerkleProofs(leaves, proofs, root, results);
+        proofsOk = proofsOk && verifyMerkleMultiProof(evenLeaves, proofTree.getMultiProof(evenIndices), root);
+        if(n > 1) {
+            proofsOk = proofsOk && !verifyMerkleProof(leaves[0], proofs[n - 1], root);
+        }
+    }
+    std::cout << "Preuves simples, groupees et multi-preuves correctes: " << (proofsOk ? "OUI" : "NON") << std::endl << std::endl;
+
+    std::cout << "=== Test 8: Calcul parallele du root ===" << std::endl;
+    std::vector<std::string> manyTransactions;
+    for(int i = 0; i < 5000; i++) {
+        std::stringstream ss;
+        ss << "Transaction parallele " << i;
+        manyTransactions.push_back(ss.str());
+    }
+    bool parallelOk = true;
+    for(unsigned threads = 1; threads <= 4; threads *= 2) {
+        ParallelMerkleTree parallelTree(threads);
+        for(size_t n = 1; n <= manyTransactions.size(); n = n * 3 + 1) {
+            std::vector<std::string> txs(manyTransactions.begin(), manyTransactions.begin() + n);
+            if(parallelTree.getMerkleRoot(txs) != tree.getMerkleRoot(txs)) {
+                parallelOk = false;
+            }
+        }
+        if(parallelTree.getMerkleRoot(manyTransactions) != tree.getMerkleRoot(manyTransactions)) {
+            parallelOk = false;
+        }
+    }
+    std::cout << "Roots paralleles identiques (1, 2 et 4 threads): " << (parallelOk ? "OUI" : "NON") << std::endl << std::endl;
+
+    std::cout << "=== Test 9: Root en streaming ===" << std::endl;
+    bool streamingOk = true;
+    for(size_t n = 0; n <= 70; n++) {
+        std::vector<std::string> txs(manyTransactions.begin(), manyTransactions.begin() + n);
+        StreamingMerkleRoot streaming;
+        for(const auto& tx : txs) {
+            streaming.addTransaction(tx);
+        }
+        if(streaming.getRoot() != tree.getMerkleRoot(txs)) {
+            streamingOk = false;
+        }
+    }
+    std::cout << "Roots identiques pour 0 a 70 transactions: " << (streamingOk ? "OUI" : "NON") << std::endl;
+
+    const char* dumpPath = "merkle_stream_dump.txt";
+    {
+        std::ofstream dump(dumpPath, std::ios::binary);
+        for(const auto& tx : manyTransactions) {
+            dump << tx << "\n";
+        }
+    }
+    StreamingMerkleRoot fromFile;
+    bool fileRead = fromFile.addTransactionsFromFile(dumpPath, TX_NEWLINE_DELIMITED);
+    std::remove(dumpPath);
+    std::cout << "Fichier mmap (" << fromFile.size() << " transactions) identique: "
+              << (fileRead && fromFile.getRoot() == tree.getMerkleRoot(manyTransactions) ? "OUI" : "NON") << std::endl;
+
+    std::stringstream prefixed;
+    for(const auto& tx : manyTransactions) {
+        uint32_t length = (uint32_t)tx.size();
+        char header[4] = {(char)(length >> 24), (char)(length >> 16), (char)(length >> 8), (char)length};
+        prefixed.write(header, 4);
+        prefixed << tx;
+    }
+    StreamingMerkleRoot fromStream;
+    bool streamRead = fromStream.addTransactions(prefixed, TX_LENGTH_PREFIXED);
+    std::cout << "Flux avec prefixe de longueur identique: "
+              << (streamRead && fromStream.getRoot() == tree.getMerkleRoot(manyTransactions) ? "OUI" : "NON") << std::endl;
 
     return 0;
 }
\ No newline at end of file
@@ -7,54 +7,131 @@
 
 #include <string>
 #include <vector>
+#include <cstring>
+#include <algorithm>
 #include <openssl/sha.h>
-#include <iomanip>
-#include <sstream>
+#include "../0-Common/digest.h"
+#include "../0-Common/sha256_multibuffer.h"
+
+// How two child digests are combined into their parent
+enum MerkleHashMode {
+    MERKLE_HEX_COMPAT,  // SHA256(hex(left) + hex(right)), roots of existing chains
+    MERKLE_BINARY       // SHA256(left || right) on the raw 32-byte digests
+};
+
+// Working buffers of MerkleTree::reduceLevel. Sized by the first (largest)
+// level and reused by the levels above and by later calls.
+struct MerkleScratch {
+    std::vector<uint8_t> preimages;
+    std::vector<const uint8_t*> pointers;
+    std::vector<Digest> parents;
+};
 
 class MerkleTree {
 private:
-    std::string calculateHash(const std::string& data) {
-        unsigned char hash[SHA256_DIGEST_LENGTH];
-        SHA256((unsigned char*)data.c_str(), data.size(), hash);
+    MerkleHashMode mode;
+    // Leaves and internal nodes of the current computation, reused between calls
+    std::vector<Digest> nodes;
+    MerkleScratch scratch;
 
-        std::stringstream ss;
-        for(int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
-            ss << std::hex << std::setw(2) << std::setfill('0') << (int)hash[i];
-        }
-        return ss.str();
-    }
+public:
+    MerkleTree(MerkleHashMode hashMode = MERKLE_HEX_COMPAT) : mode(hashMode) {}
 
-    std::string combineHashes(const std::string& left, const std::string& right) {
-        return calculateHash(left + right);
+    static Digest hashLeaf(const std::string& data) {
+        return sha256Digest(data);
     }
 
-public:
-    std::string getMerkleRoot(std::vector<std::string> transactions) {
-        if(transactions.empty()) {
-            return calculateHash("");
+    static Digest combineDigests(const Digest& left, const Digest& right, MerkleHashMode hashMode) {
+        if(hashMode == MERKLE_HEX_COMPAT) {
+            char buffer[4 * SHA256_DIGEST_LENGTH];
+            digestToHex(left, buffer);
+            digestToHex(right, buffer + 2 * SHA256_DIGEST_LENGTH);
+            return sha256Digest(buffer, sizeof(buffer));
         }
 
-        std::vector<std::string> currentLevel;
-        for(const auto& tx : transactions) {
-            currentLevel.push_back(calculateHash(tx));
-        }
+        uint8_t buffer[2 * SHA256_DIGEST_LENGTH];
+        std::memcpy(buffer, left.data(), SHA256_DIGEST_LENGTH);
+        std::memcpy(buffer + SHA256_DIGEST_LENGTH, right.data(), SHA256_DIGEST_LENGTH);
+        return sha256Digest(buffer, sizeof(buffer));
+    }
 
-        while(currentLevel.size() > 1) {
-            std::vector<std::string> nextLevel;
+    // Replaces the first (count + 1) / 2 digests of level by the next level up.
+    // All parents of a level have the same preimage length, so they are
+    // hashed together by the multi-buffer SHA-256 backend.
+    static size_t reduceLevel(Digest* level, size_t count, MerkleHashMode hashMode, MerkleScratch& scratch) {
+        const size_t length = (hashMode == MERKLE_HEX_COMPAT) ? 4 * SHA256_DIGEST_LENGTH
+                                                              : 2 * SHA256_DIGEST_LENGTH;
+        size_t next = (count + 1) / 2;
+        std::vector<uint8_t>& preimages = scratch.preimages;
+        std::vector<const uint8_t*>& pointers = scratch.pointers;
+        std::vector<Digest>& parents = scratch.parents;
+        pointers.resize(next);
+        parents.resize(next);
 
-            for(size_t i = 0; i < currentLevel.size(); i += 2) {
-                if(i + 1 < currentLevel.size()) {
-                    nextLevel.push_back(combineHashes(currentLevel[i], currentLevel[i + 1]));
+        if(hashMode == MERKLE_HEX_COMPAT) {
+            if(preimages.size() < next * length) {
+                preimages.resize(next * length);
+            }
+            for(size_t j = 0; j < next; j++) {
+                const Digest& left = level[2 * j];
+                const Digest& right = (2 * j + 1 < count) ? level[2 * j + 1] : left;
+                char* preimage = (char*)&preimages[j * length];
+                digestToHex(left, preimage);
+                digestToHex(right, preimage + 2 * SHA256_DIGEST_LENGTH);
+                pointers[j] = (const uint8_t*)preimage;
+            }
+        } else {
+            // Two neighbouring digests already form the 64-byte preimage
+            for(size_t j = 0; j < next; j++) {
+                if(2 * j + 1 < count) {
+                    pointers[j] = level[2 * j].data();
                 } else {
-                    nextLevel.push_back(combineHashes(currentLevel[i], currentLevel[i]));
+                    if(preimages.size() < length) {
+                        preimages.resize(length);
+                    }
+                    std::memcpy(&preimages[0], level[2 * j].data(), SHA256_DIGEST_LENGTH);
+                    std::memcpy(&preimages[SHA256_DIGEST_LENGTH], level[2 * j].data(), SHA256_DIGEST_LENGTH);
+                    pointers[j] = &preimages[0];
                 }
             }
+        }
+
+        sha256Batch(pointers.data(), length, next, parents.data());
+        std::copy(parents.begin(), parents.begin() + next, level);
+        return next;
+    }
 
-            currentLevel = nextLevel;
+    // Reduces count leaf digests level by level inside the same buffer.
+    // An odd level duplicates its last node, like the original implementation.
+    static Digest reduceInPlace(Digest* level, size_t count, MerkleHashMode hashMode, MerkleScratch& scratch) {
+        while(count > 1) {
+            count = reduceLevel(level, count, hashMode, scratch);
         }
+        return level[0];
+    }
 
-        return currentLevel[0];
+    static Digest reduceInPlace(Digest* level, size_t count, MerkleHashMode hashMode) {
+        MerkleScratch scratch;
+        return reduceInPlace(level, count, hashMode, scratch);
     }
+
+    Digest getMerkleRootDigest(const std::vector<std::string>& transactions) {
+        if(transactions.empty()) {
+            return hashLeaf("");
+        }
+
+        nodes.resize(transactions.size());
+        sha256BatchStrings(transactions, nodes.data());
+
+        return reduceInPlace(nodes.data(), nodes.size(), mode, scratch);
+    }
+
+    std::string getMerkleRoot(const std::vector<std::string>& transactions) {
+        return digestToHex(getMerkleRootDigest(transactions));
+    }
+
+    MerkleHashMode getHashMode() const { return mode; }
+    void setHashMode(MerkleHashMode hashMode) { mode = hashMode; }
 };
 
 
@@ -0,0 +1,99 @@
+//
+// Created by abdelaziz on 10/17/2026.
+//
+
+#ifndef IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_PARALLEL_MERKLE_TREE_H
+#define IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_PARALLEL_MERKLE_TREE_H
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "merkle_tree.h"
+#include "../0-Common/thread_pool.h"
+
+// Merkle root computed on several cores. The leaves are cut into aligned
+// subtrees of 2^k leaves; each worker hashes its leaves and reduces its
+// subtree k levels, then the subtree roots are combined on the calling thread.
+// Roots are identical to MerkleTree::getMerkleRoot in the same mode.
+class ParallelMerkleTree {
+private:
+    MerkleHashMode mode;
+    ThreadPool pool;
+    std::vector<Digest> nodes;
+    // Buffers of the serial reductions on the calling thread
+    MerkleScratch scratch;
+
+    // Below this many leaves per worker the serial path is faster
+    static const size_t MIN_LEAVES_PER_TASK = 256;
+
+    // Reduces exactly levelCount levels of a subtree starting at level[0].
+    // A lone node is paired with itself even when it is the last of its
+    // subtree, because the level it belongs to is odd across the whole tree.
+    void reduceSubtree(Digest* level, size_t count, size_t levelCount) const {
+        MerkleScratch local;
+        for(size_t l = 0; l < levelCount; l++) {
+            count = MerkleTree::reduceLevel(level, count, mode, local);
+        }
+    }
+
+public:
+    // threads = 0 uses one worker per hardware thread
+    explicit ParallelMerkleTree(unsigned threads = 0, MerkleHashMode hashMode = MERKLE_HEX_COMPAT)
+            : mode(hashMode), pool(threads) {}
+
+    // leafDigest(items[i]) must return the leaf digest of item i
+    template <typename T, typename LeafFn>
+    Digest getMerkleRootDigest(const std::vector<T>& items, LeafFn leafDigest) {
+        size_t count = items.size();
+        if(count == 0) {
+            return MerkleTree::hashLeaf("");
+        }
+        nodes.resize(count);
+
+        // Subtree size: largest power of two giving about 4 tasks per worker
+        size_t subtreeLevels = 0;
+        while(((size_t)2 << subtreeLevels) * pool.size() * 4 <= count) {
+            subtreeLevels++;
+        }
+        size_t subtreeSize = (size_t)1 << subtreeLevels;
+        size_t taskCount = (count + subtreeSize - 1) / subtreeSize;
+
+        if(taskCount < 2 || count < MIN_LEAVES_PER_TASK * 2) {
+            for(size_t i = 0; i < count; i++) {
+                nodes[i] = leafDigest(items[i]);
+            }
+            return MerkleTree::reduceInPlace(nodes.data(), count, mode, scratch);
+        }
+
+        pool.run(taskCount, [&](size_t task) {
+            size_t begin = task * subtreeSize;
+            size_t end = std::min(begin + subtreeSize, count);
+            for(size_t i = begin; i < end; i++) {
+                nodes[i] = leafDigest(items[i]);
+            }
+            reduceSubtree(&nodes[begin], end - begin, subtreeLevels);
+        });
+
+        std::vector<Digest> top(taskCount);
+        for(size_t task = 0; task < taskCount; task++) {
+            top[task] = nodes[task * subtreeSize];
+        }
+        return MerkleTree::reduceInPlace(top.data(), top.size(), mode, scratch);
+    }
+
+    Digest getMerkleRootDigest(const std::vector<std::string>& transactions) {
+        return getMerkleRootDigest(transactions, [](const std::string& tx) {
+            return MerkleTree::hashLeaf(tx);
+        });
+    }
+
+    std::string getMerkleRoot(const std::vector<std::string>& transactions) {
+        return digestToHex(getMerkleRootDigest(transactions));
+    }
+
+    size_t getThreadCount() const { return pool.size(); }
+    MerkleHashMode getHashMode() const { return mode; }
+};
+
+
+#endif //IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_PARALLEL_MERKLE_TREE_H
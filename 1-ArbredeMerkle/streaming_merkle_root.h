@@ -0,0 +1,169 @@
+//
+// Created by abdelaziz on 10/17/2026.
+//
+
+#ifndef IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_STREAMING_MERKLE_ROOT_H
+#define IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_STREAMING_MERKLE_ROOT_H
+
+#include <string>
+#include <vector>
+#include <istream>
+#include <cstdint>
+#include "merkle_tree.h"
+#include "../0-Common/mapped_file.h"
+
+// How transactions are laid out in a dump
+enum TransactionFormat {
+    TX_NEWLINE_DELIMITED,   // one transaction per line, '\n' not included
+    TX_LENGTH_PREFIXED      // 4-byte big-endian length, then the bytes
+};
+
+// Merkle root of a transaction stream that never holds more than one
+// pending digest per level: pending[k] is the root of a complete subtree
+// of 2^k leaves, like the bits of a binary counter.
+// Roots are identical to MerkleTree::getMerkleRoot in the same mode.
+class StreamingMerkleRoot {
+private:
+    MerkleHashMode mode;
+    std::vector<Digest> pending;
+    std::vector<bool> present;
+    uint64_t count;
+
+public:
+    StreamingMerkleRoot(MerkleHashMode hashMode = MERKLE_HEX_COMPAT)
+            : mode(hashMode), count(0) {}
+
+    void addLeafDigest(const Digest& leaf) {
+        Digest node = leaf;
+        size_t level = 0;
+        while(level < present.size() && present[level]) {
+            node = MerkleTree::combineDigests(pending[level], node, mode);
+            present[level] = false;
+            level++;
+        }
+        if(level == present.size()) {
+            pending.push_back(Digest());
+            present.push_back(false);
+        }
+        pending[level] = node;
+        present[level] = true;
+        count++;
+    }
+
+    void addTransaction(const void* data, size_t size) {
+        addLeafDigest(sha256Digest(data, size));
+    }
+
+    void addTransaction(const std::string& tx) {
+        addLeafDigest(MerkleTree::hashLeaf(tx));
+    }
+
+    // Folds the pending subtrees from the lowest level up. A node that is
+    // alone at the end of its level is paired with itself, as in getMerkleRoot.
+    Digest getRootDigest() const {
+        if(count == 0) {
+            return MerkleTree::hashLeaf("");
+        }
+
+        size_t top = present.size() - 1;
+        while(!present[top]) {
+            top--;
+        }
+
+        bool carrying = false;
+        Digest carry;
+        for(size_t level = 0; level <= top; level++) {
+            if(!carrying) {
+                if(!present[level]) {
+                    continue;
+                }
+                if(level == top) {
+                    return pending[level];
+                }
+                carry = MerkleTree::combineDigests(pending[level], pending[level], mode);
+                carrying = true;
+            } else if(present[level]) {
+                carry = MerkleTree::combineDigests(pending[level], carry, mode);
+            } else {
+                carry = MerkleTree::combineDigests(carry, carry, mode);
+            }
+        }
+        return carry;
+    }
+
+    std::string getRoot() const {
+        return digestToHex(getRootDigest());
+    }
+
+    uint64_t size() const { return count; }
+
+    void reset() {
+        pending.clear();
+        present.clear();
+        count = 0;
+    }
+
+    // Returns false on a truncated length-prefixed record
+    bool addTransactions(std::istream& in, TransactionFormat format) {
+        std::string tx;
+        if(format == TX_NEWLINE_DELIMITED) {
+            while(std::getline(in, tx)) {
+                addTransaction(tx);
+            }
+            return true;
+        }
+
+        unsigned char header[4];
+        while(in.read((char*)header, 4)) {
+            uint32_t length = ((uint32_t)header[0] << 24) | ((uint32_t)header[1] << 16) |
+                              ((uint32_t)header[2] << 8) | (uint32_t)header[3];
+            tx.resize(length);
+            if(length > 0 && !in.read(&tx[0], length)) {
+                return false;
+            }
+            addTransaction(tx);
+        }
+        return in.gcount() == 0;
+    }
+
+    // Hashes the transactions straight from the mapped pages, without copying them
+    bool addTransactions(const uint8_t* data, size_t size, TransactionFormat format) {
+        size_t offset = 0;
+        if(format == TX_NEWLINE_DELIMITED) {
+            while(offset < size) {
+                const void* found = std::memchr(data + offset, '\n', size - offset);
+                size_t end = found ? (size_t)((const uint8_t*)found - data) : size;
+                addTransaction(data + offset, end - offset);
+                offset = end + 1;
+            }
+            return true;
+        }
+
+        while(offset < size) {
+            if(size - offset < 4) {
+                return false;
+            }
+            const uint8_t* header = data + offset;
+            uint32_t length = ((uint32_t)header[0] << 24) | ((uint32_t)header[1] << 16) |
+                              ((uint32_t)header[2] << 8) | (uint32_t)header[3];
+            offset += 4;
+            if(size - offset < length) {
+                return false;
+            }
+            addTransaction(data + offset, length);
+            offset += length;
+        }
+        return true;
+    }
+
+    bool addTransactionsFromFile(const std::string& path, TransactionFormat format) {
+        MappedFile file;
+        if(!file.open(path)) {
+            return false;
+        }
+        return addTransactions(file.data(), file.size(), format);
+    }
+};
+
+
+#endif //IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_STREAMING_MERKLE_ROOT_H
@@ -0,0 +1,168 @@
+//
+// Created by abdelaziz on 10/17/2026.
+//
+
+#ifndef IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_DIFFICULTY_RETARGET_H
+#define IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_DIFFICULTY_RETARGET_H
+
+#include <deque>
+#include <algorithm>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstdint>
+#include "../0-Common/difficulty_target.h"
+
+struct RetargetParams {
+    double blockSeconds;            // wanted time between two blocks
+    size_t window;                  // number of recent blocks looked at
+    uint32_t maxAdjustment;         // per retarget, the target moves by at most this factor
+    DifficultyTarget initialTarget; // used until the window holds two blocks
+    DifficultyTarget limit;         // easiest target ever allowed
+
+    RetargetParams(double seconds = 1.0, size_t windowBlocks = 10,
+                   const DifficultyTarget& initial = DifficultyTarget::fromHexZeros(3))
+            : blockSeconds(seconds), window(windowBlocks), maxAdjustment(4),
+              initialTarget(initial), limit(DifficultyTarget::fromLeadingZeroBits(1)) {}
+};
+
+// Computes the target of the next block from the last `window` blocks:
+// the average of their targets, scaled by the time they actually took over
+// the time they should have taken. Only integer arithmetic on the targets,
+// so a validator replaying the same timestamps gets the same bytes.
+class DifficultyRetargeter {
+private:
+    struct Sample {
+        double timestamp;
+        DifficultyTarget target;
+    };
+
+    RetargetParams params;
+    std::deque<Sample> samples;
+
+public:
+    explicit DifficultyRetargeter(const RetargetParams& retargetParams = RetargetParams())
+            : params(retargetParams) {}
+
+    // Blocks must be recorded in chain order
+    void recordBlock(double timestamp, const DifficultyTarget& target) {
+        Sample sample;
+        sample.timestamp = timestamp;
+        sample.target = target;
+        samples.push_back(sample);
+        while(samples.size() > params.window) {
+            samples.pop_front();
+        }
+    }
+
+    DifficultyTarget nextTarget() const {
+        if(samples.size() < 2) {
+            return params.initialTarget;
+        }
+
+        size_t n = samples.size();
+        DifficultyTarget average((Digest()));
+        for(const Sample& s : samples) {
+            average = average.plus(s.target.scaled(1, (uint32_t)n));
+        }
+
+        // Clamped so one retarget moves by at most maxAdjustment
+        double expected = params.blockSeconds * (n - 1);
+        double actual = samples.back().timestamp - samples.front().timestamp;
+        actual = std::max(expected / params.maxAdjustment, std::min(expected * params.maxAdjustment, actual));
+
+        // The ratio as two integers, the larger scaled to 2^31 so that both
+        // fit the 32-bit operands of scaled() whatever the block time
+        double unit = std::ldexp(1.0, 31) / std::max(actual, expected);
+        uint32_t numerator = (uint32_t)std::llround(actual * unit);
+        uint32_t denominator = (uint32_t)std::max<long long>(std::llround(expected * unit), 1);
+        DifficultyTarget next = average.scaled(numerator, denominator);
+        return DifficultyTarget::harder(next, params.limit);
+    }
+
+    void reset() { samples.clear(); }
+    const RetargetParams& getParams() const { return params; }
+};
+
+// Replays a hash-rate profile against the retargeter. Block times are drawn
+// from the exponential distribution of a real miner: mean = expected hashes
+// of the target / hash rate.
+class RetargetSimulation {
+public:
+    struct Phase {
+        size_t blocks;
+        double hashesPerSecond;
+    };
+
+    struct PhaseReport {
+        double hashesPerSecond;
+        size_t blocksToConverge;    // blocks until the window average is within tolerance; = blocks if never
+        double meanBlockSeconds;    // over the phase once converged (whole phase if never)
+    };
+
+    struct Report {
+        std::vector<double> blockSeconds;
+        std::vector<double> difficultyBits;
+        std::vector<PhaseReport> phases;
+    };
+
+    static Report run(const RetargetParams& params, const std::vector<Phase>& profile,
+                      double tolerance = 0.25, unsigned seed = 42) {
+        DifficultyRetargeter retargeter(params);
+        std::mt19937_64 rng(seed);
+        std::exponential_distribution<double> unitExponential(1.0);
+        Report report;
+
+        double now = 0;
+        retargeter.recordBlock(now, params.initialTarget);
+        for(const Phase& phase : profile) {
+            PhaseReport phaseReport;
+            phaseReport.hashesPerSecond = phase.hashesPerSecond;
+            phaseReport.blocksToConverge = phase.blocks;
+            std::deque<double> recent;
+            double convergedTime = 0;
+            size_t convergedBlocks = 0;
+
+            for(size_t b = 0; b < phase.blocks; b++) {
+                DifficultyTarget target = retargeter.nextTarget();
+                double seconds = unitExponential(rng) * target.expectedHashes() / phase.hashesPerSecond;
+                now += seconds;
+                retargeter.recordBlock(now, target);
+                report.blockSeconds.push_back(seconds);
+                report.difficultyBits.push_back(target.getDifficultyBits());
+
+                recent.push_back(seconds);
+                if(recent.size() > params.window) {
+                    recent.pop_front();
+                }
+                double mean = 0;
+                for(double r : recent) {
+                    mean += r;
+                }
+                mean /= recent.size();
+
+                if(phaseReport.blocksToConverge == phase.blocks && recent.size() == params.window
+                   && std::fabs(mean / params.blockSeconds - 1) <= tolerance) {
+                    phaseReport.blocksToConverge = b + 1;
+                }
+                if(phaseReport.blocksToConverge < phase.blocks && b >= phaseReport.blocksToConverge) {
+                    convergedTime += seconds;
+                    convergedBlocks++;
+                }
+            }
+
+            if(convergedBlocks == 0) {
+                size_t first = report.blockSeconds.size() - phase.blocks;
+                for(size_t i = first; i < report.blockSeconds.size(); i++) {
+                    convergedTime += report.blockSeconds[i];
+                }
+                convergedBlocks = phase.blocks;
+            }
+            phaseReport.meanBlockSeconds = convergedBlocks ? convergedTime / convergedBlocks : 0;
+            report.phases.push_back(phaseReport);
+        }
+        return report;
+    }
+};
+
+#endif //IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_DIFFICULTY_RETARGET_H
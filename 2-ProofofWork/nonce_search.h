@@ -0,0 +1,242 @@
+//
+// Created by abdelaziz on 10/17/2026.
+//
+
+#ifndef IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_NONCE_SEARCH_H
+#define IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_NONCE_SEARCH_H
+
+#include <string>
+#include <vector>
+#include <climits>
+#include <algorithm>
+#include "../0-Common/sha256_multibuffer.h"
+#include "../0-Common/difficulty_target.h"
+
+inline int decimalDigits(uint64_t value) {
+    int digits = 1;
+    while(value >= 10) {
+        value /= 10;
+        digits++;
+    }
+    return digits;
+}
+
+// Largest value with the same number of decimal digits as value
+inline uint64_t lastWithSameDigits(uint64_t value) {
+    uint64_t limit = 9;
+    while(limit < value && limit < UINT64_MAX / 10) {
+        limit = limit * 10 + 9;
+    }
+    return limit < value ? UINT64_MAX : limit;
+}
+
+// Hashes prefix + decimal nonce + suffix for many nonces without redoing
+// the constant work. The whole 64-byte blocks of prefix are compressed once
+// (the midstate); each nonce then only costs the compression of the tail:
+// the leftover prefix bytes, the nonce digits and the suffix, i.e. one or
+// two blocks for a short suffix. Tails live, already padded, in a
+// preallocated buffer where only the digits are rewritten.
+class NonceHasher {
+public:
+    enum { MAX_BATCH = 16 };
+
+private:
+    uint32_t midstate[8];
+    uint64_t absorbed;
+    std::string head;
+    std::string suffix;
+    std::vector<uint8_t> tails;
+    size_t tailBlocks;
+    int tailDigits;
+
+    void layoutTails(int digits) {
+        size_t tailLength = head.size() + digits + suffix.size();
+        tailDigits = digits;
+        tailBlocks = sha256PaddedBlocks(tailLength);
+        tails.assign(64 * tailBlocks * MAX_BATCH, 0);
+        for(size_t k = 0; k < MAX_BATCH; k++) {
+            uint8_t* tail = &tails[64 * tailBlocks * k];
+            std::memcpy(tail, head.data(), head.size());
+            std::memcpy(tail + head.size() + digits, suffix.data(), suffix.size());
+            sha256WritePadding(tail, tailLength, absorbed + tailLength);
+        }
+    }
+
+public:
+    NonceHasher(const std::string& prefix, const std::string& nonceSuffix)
+            : absorbed(prefix.size() / 64 * 64), head(prefix, absorbed), suffix(nonceSuffix),
+              tailBlocks(0), tailDigits(0) {
+        std::memcpy(midstate, SHA256_IV, sizeof(midstate));
+        sha256CompressBlocks(midstate, (const uint8_t*)prefix.data(), absorbed / 64);
+    }
+
+    // Digests of the count (<= MAX_BATCH) nonces first, first + 1, ...,
+    // which must all have the same number of decimal digits
+    void hashConsecutive(uint64_t first, size_t count, Digest* out) {
+        int digits = decimalDigits(first);
+        if(digits != tailDigits) {
+            layoutTails(digits);
+        }
+
+        const uint8_t* pointers[MAX_BATCH];
+        uint8_t* previous = nullptr;
+        for(size_t k = 0; k < count; k++) {
+            uint8_t* tail = &tails[64 * tailBlocks * k];
+            uint8_t* digit = tail + head.size();
+            if(previous == nullptr) {
+                uint64_t value = first;
+                for(int d = digits - 1; d >= 0; d--) {
+                    digit[d] = (uint8_t)('0' + value % 10);
+                    value /= 10;
+                }
+            } else {
+                // Decimal increment of the previous lane, no division
+                std::memcpy(digit, previous, digits);
+                int d = digits - 1;
+                while(digit[d] == '9') {
+                    digit[d--] = '0';
+                }
+                digit[d]++;
+            }
+            previous = digit;
+            pointers[k] = tail;
+        }
+
+        sha256FinishPadded(midstate, pointers, tailBlocks, count, out);
+    }
+
+    Digest hash(uint64_t nonce) {
+        Digest out;
+        hashConsecutive(nonce, 1, &out);
+        return out;
+    }
+};
+
+// Scans the nonces first..last in order and stops at the first one whose
+// SHA-256 of prefix + nonce + suffix meets target.
+// Consecutive nonces with the same number of digits give preimages of the
+// same length, so they are hashed as one multi-buffer batch from the
+// prefix midstate. hashes receives the number of candidates hashed.
+inline bool findNonceInRange(const std::string& prefix, const std::string& suffix,
+                             uint64_t first, uint64_t last, const DifficultyTarget& target,
+                             uint64_t& found, std::string& hashHex, uint64_t& hashes) {
+    const uint64_t BATCH = NonceHasher::MAX_BATCH;
+    NonceHasher hasher(prefix, suffix);
+    Digest digests[NonceHasher::MAX_BATCH];
+    hashes = 0;
+
+    uint64_t next = first;
+    while(next <= last) {
+        uint64_t end = std::min(last, lastWithSameDigits(next));
+        uint64_t count = std::min(BATCH, end - next + 1);
+
+        hasher.hashConsecutive(next, count, digests);
+        for(uint64_t k = 0; k < count; k++) {
+            if(target.isMetBy(digests[k])) {
+                found = next + k;
+                hashHex = digestToHex(digests[k]);
+                hashes += k + 1;
+                return true;
+            }
+        }
+        hashes += count;
+
+        if(next + count - 1 == last) {
+            break;
+        }
+        next += count;
+    }
+    return false;
+}
+
+// Midstate hashing for fixed binary headers: the nonce is a big-endian
+// field of nonceBytes (4 or 8) at nonceOffset. Everything before the 64-byte
+// block holding the nonce is compressed once; candidates only rewrite the
+// nonce bytes of their padded tail.
+class HeaderNonceHasher {
+public:
+    enum { MAX_BATCH = 16 };
+
+private:
+    uint32_t midstate[8];
+    size_t absorbed;
+    size_t nonceInTail;
+    size_t nonceBytes;
+    size_t tailBlocks;
+    std::vector<uint8_t> tails;
+
+public:
+    HeaderNonceHasher(const uint8_t* header, size_t size, size_t nonceOffset, size_t nonceWidth = 4)
+            : absorbed(nonceOffset / 64 * 64), nonceInTail(nonceOffset - absorbed), nonceBytes(nonceWidth) {
+        std::memcpy(midstate, SHA256_IV, sizeof(midstate));
+        sha256CompressBlocks(midstate, header, absorbed / 64);
+
+        size_t tailLength = size - absorbed;
+        tailBlocks = sha256PaddedBlocks(tailLength);
+        tails.assign(64 * tailBlocks * MAX_BATCH, 0);
+        for(size_t k = 0; k < MAX_BATCH; k++) {
+            uint8_t* tail = &tails[64 * tailBlocks * k];
+            std::memcpy(tail, header + absorbed, tailLength);
+            sha256WritePadding(tail, tailLength, size);
+        }
+    }
+
+    // Digests of the count (<= MAX_BATCH) nonces first, first + 1, ...
+    void hashConsecutive(uint64_t first, size_t count, Digest* out) {
+        const uint8_t* pointers[MAX_BATCH];
+        for(size_t k = 0; k < count; k++) {
+            uint8_t* tail = &tails[64 * tailBlocks * k];
+            uint64_t value = first + k;
+            for(size_t b = nonceBytes; b > 0; b--, value >>= 8) {
+                tail[nonceInTail + b - 1] = (uint8_t)value;
+            }
+            pointers[k] = tail;
+        }
+        sha256FinishPadded(midstate, pointers, tailBlocks, count, out);
+    }
+};
+
+// findNonceInRange for a binary header; first..last must fit in nonceBytes
+inline bool findHeaderNonceInRange(const uint8_t* header, size_t size, size_t nonceOffset, size_t nonceBytes,
+                                   uint64_t first, uint64_t last, const DifficultyTarget& target,
+                                   uint64_t& found, std::string& hashHex, uint64_t& hashes) {
+    const uint64_t BATCH = HeaderNonceHasher::MAX_BATCH;
+    HeaderNonceHasher hasher(header, size, nonceOffset, nonceBytes);
+    Digest digests[HeaderNonceHasher::MAX_BATCH];
+    hashes = 0;
+
+    for(uint64_t next = first; next <= last; next += BATCH) {
+        uint64_t count = std::min(BATCH, last - next + 1);
+        hasher.hashConsecutive(next, count, digests);
+        for(uint64_t k = 0; k < count; k++) {
+            if(target.isMetBy(digests[k])) {
+                found = next + k;
+                hashHex = digestToHex(digests[k]);
+                hashes += k + 1;
+                return true;
+            }
+        }
+        hashes += count;
+        if(last - next < BATCH) {
+            break;
+        }
+    }
+    return false;
+}
+
+// Same search as the nonce++ loop of mineBlock: the first nonce after start
+// that solves the block. The 64-bit space cannot wrap around: returns false,
+// with hashHex empty, once it is exhausted.
+inline bool findNonceBatched(const std::string& prefix, const std::string& suffix,
+                             uint64_t start, const DifficultyTarget& target,
+                             uint64_t& found, std::string& hashHex) {
+    uint64_t hashes = 0;
+    if(start < UINT64_MAX
+       && findNonceInRange(prefix, suffix, start + 1, UINT64_MAX, target, found, hashHex, hashes)) {
+        return true;
+    }
+    hashHex = "";
+    return false;
+}
+
+#endif //IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_NONCE_SEARCH_H
@@ -0,0 +1,170 @@
+//
+// Created by abdelaziz on 10/17/2026.
+//
+
+#ifndef IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_PARALLEL_MINER_H
+#define IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_PARALLEL_MINER_H
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include "../0-Common/thread_pool.h"
+
+struct MiningResult {
+    bool found;
+    bool cancelled;
+    uint32_t extraNonce;
+    uint64_t nonce;
+    std::string hash;
+    std::vector<uint64_t> hashesPerThread;
+    double seconds;
+
+    MiningResult() : found(false), cancelled(false), extraNonce(0), nonce(0), seconds(0) {}
+
+    uint64_t totalHashes() const {
+        uint64_t total = 0;
+        for(uint64_t h : hashesPerThread) {
+            total += h;
+        }
+        return total;
+    }
+
+    double hashRate() const {
+        return seconds > 0 ? totalHashes() / seconds : 0;
+    }
+
+    double threadHashRate(size_t thread) const {
+        return seconds > 0 ? hashesPerThread[thread] / seconds : 0;
+    }
+};
+
+// Splits the nonce space into chunks handed out in order to N workers.
+// A chunk is searched in slices of pollNonces; between slices a worker
+// stops if it was cancelled or if another worker found a solution below
+// its next slice. Workers on earlier chunks go on to the end of theirs,
+// so the result is the lowest solving nonce: the same block the serial
+// nonce++ loop would produce.
+class ParallelMiner {
+private:
+    ThreadPool pool;
+    uint64_t chunkSize;
+    uint64_t pollNonces;
+
+public:
+    // threads = 0 uses one worker per hardware thread. A slow hash wants a
+    // small pollInterval, so that cancel is seen soon after it is raised.
+    explicit ParallelMiner(unsigned threads = 0, uint64_t nonceChunk = 4096, uint64_t pollInterval = 256)
+            : pool(threads), chunkSize(nonceChunk), pollNonces(pollInterval == 0 ? 1 : pollInterval) {}
+
+    // search(first, last, nonce, hash, hashes) scans first..last in order and
+    // returns true with the first solving nonce, like findNonceInRange.
+    // cancel, when set by another thread (e.g. a new chain tip), stops all
+    // workers within pollInterval nonces.
+    template <typename RangeSearch>
+    MiningResult mine(RangeSearch search, uint64_t firstNonce, uint64_t lastNonce,
+                      const std::atomic<bool>* cancel = nullptr) {
+        MiningResult result;
+        result.hashesPerThread.assign(pool.size(), 0);
+        if(firstNonce > lastNonce) {
+            return result;
+        }
+
+        std::atomic<uint64_t> nextChunk(0);
+        std::atomic<uint64_t> best(UINT64_MAX);
+        std::mutex resultMutex;
+        uint64_t chunkCount = (lastNonce - firstNonce) / chunkSize + 1;
+
+        auto start = std::chrono::steady_clock::now();
+        pool.run(pool.size(), [&](size_t worker) {
+            while(true) {
+                if(cancel != nullptr && cancel->load()) {
+                    return;
+                }
+                uint64_t chunk = nextChunk.fetch_add(1);
+                if(chunk >= chunkCount) {
+                    return;
+                }
+                uint64_t first = firstNonce + chunk * chunkSize;
+                if(first > best.load()) {
+                    return;
+                }
+                uint64_t last = (lastNonce - first < chunkSize - 1) ? lastNonce : first + chunkSize - 1;
+
+                for(uint64_t slice = first; ; slice += pollNonces) {
+                    if(slice > best.load() || (cancel != nullptr && cancel->load())) {
+                        return;
+                    }
+                    uint64_t sliceLast = (last - slice < pollNonces - 1) ? last : slice + pollNonces - 1;
+                    uint64_t nonce = 0;
+                    uint64_t hashes = 0;
+                    std::string hash;
+                    bool found = search(slice, sliceLast, nonce, hash, hashes);
+                    result.hashesPerThread[worker] += hashes;
+
+                    if(found) {
+                        std::lock_guard<std::mutex> lock(resultMutex);
+                        if(nonce < best.load()) {
+                            best.store(nonce);
+                            result.nonce = nonce;
+                            result.hash = hash;
+                            result.found = true;
+                        }
+                        break;
+                    }
+                    if(sliceLast == last) {
+                        break;
+                    }
+                }
+            }
+        });
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if(cancel != nullptr && cancel->load()) {
+            result.cancelled = true;
+            result.found = false;
+        }
+        return result;
+    }
+
+    // Searches the (extraNonce, nonce) pairs in order: firstNonce..lastNonce
+    // with firstExtra, then 0..lastNonce with each following extra nonce up
+    // to lastExtra. Each extra nonce is one round of mine(), so workers
+    // always hold disjoint pairs and the result is still the lowest solving
+    // pair. search(extra, first, last, nonce, hash, hashes) is the range search.
+    template <typename ExtendedSearch>
+    MiningResult mineExtended(ExtendedSearch search, uint32_t firstExtra, uint32_t lastExtra,
+                              uint64_t firstNonce, uint64_t lastNonce,
+                              const std::atomic<bool>* cancel = nullptr) {
+        MiningResult total;
+        total.hashesPerThread.assign(pool.size(), 0);
+
+        for(uint64_t extra = firstExtra; extra <= lastExtra; extra++) {
+            MiningResult round = mine(
+                    [&](uint64_t first, uint64_t last, uint64_t& found, std::string& foundHash, uint64_t& hashes) {
+                        return search((uint32_t)extra, first, last, found, foundHash, hashes);
+                    },
+                    extra == firstExtra ? firstNonce : 0, lastNonce, cancel);
+
+            for(size_t t = 0; t < round.hashesPerThread.size(); t++) {
+                total.hashesPerThread[t] += round.hashesPerThread[t];
+            }
+            total.seconds += round.seconds;
+            if(round.found || round.cancelled) {
+                total.found = round.found;
+                total.cancelled = round.cancelled;
+                total.extraNonce = (uint32_t)extra;
+                total.nonce = round.nonce;
+                total.hash = round.hash;
+                return total;
+            }
+        }
+        return total;
+    }
+
+    size_t getThreadCount() const { return pool.size(); }
+};
+
+#endif //IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_PARALLEL_MINER_H
@@ -3,8 +3,10 @@
 //
 
 #include "proof_of_work.h"
+#include "difficulty_retarget.h"
 #include <iostream>
 #include <chrono>
+#include <thread>
 
 int main() {
     std::cout << "=== Test Proof of Work avec differentes difficultes ===" << std::endl << std::endl;
@@ -47,7 +49,175 @@ int main() {
     b2.mineBlock(3);
     testChain.addBlock(b2);
 
-    std::cout << "Chaine initiale valide: " << (testChain.isChainValid() ? "OUI" : "NON") << std::endl;
+    std::cout << "Chaine initiale valide: " << (testChain.isChainValid() ? "OUI" : "NON") << std::endl << std::endl;
+
+    std::cout << "=== Test minage par lots (SHA-256 " << sha256BackendName(sha256ActiveBackend()) << ") ===" << std::endl;
+    Block batched(3, testChain.getLastBlock().getHash(), "Transaction 3");
+    batched.mineBlock(3);
+
+    uint64_t expectedNonce = 0;
+    std::string expectedHash;
+    do {
+        expectedNonce++;
+        std::stringstream ss;
+        ss << batched.getIndex() << batched.getPreviousHash() << batched.getData()
+           << batched.getTimestamp() << batched.getTarget().toHex() << expectedNonce;
+        expectedHash = digestToHex(sha256Digest(ss.str()));
+    } while(expectedHash.substr(0, 3) != "000");
+
+    std::cout << "Meme nonce que la boucle sequentielle: "
+              << (batched.getNonce() == expectedNonce && batched.getHash() == expectedHash ? "OUI" : "NON")
+              << std::endl << std::endl;
+
+    std::cout << "=== Test midstate SHA-256 ===" << std::endl;
+    std::stringstream header;
+    header << batched.getIndex() << batched.getPreviousHash() << batched.getData() << batched.getTimestamp()
+           << batched.getTarget().toHex();
+    NonceHasher hasher(header.str(), "");
+    const uint64_t SAMPLES = 200000;
+
+    bool identical = true;
+    auto fullStart = std::chrono::high_resolution_clock::now();
+    std::vector<std::string> fullHashes;
+    for(uint64_t n = 1; n <= SAMPLES; n++) {
+        std::stringstream ss;
+        ss << header.str() << n;
+        fullHashes.push_back(digestToHex(sha256Digest(ss.str())));
+    }
+    double fullSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - fullStart).count();
+
+    auto midStart = std::chrono::high_resolution_clock::now();
+    std::vector<Digest> midHashes(SAMPLES);
+    for(uint64_t n = 1; n <= SAMPLES; ) {
+        uint64_t count = std::min<uint64_t>((uint64_t)NonceHasher::MAX_BATCH, lastWithSameDigits(n) - n + 1);
+        count = std::min(count, SAMPLES - n + 1);
+        hasher.hashConsecutive(n, count, &midHashes[n - 1]);
+        n += count;
+    }
+    double midSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - midStart).count();
+
+    for(uint64_t n = 1; n <= SAMPLES; n++) {
+        identical = identical && digestToHex(midHashes[n - 1]) == fullHashes[n - 1];
+    }
+    std::cout << "Hashes identiques pour " << SAMPLES << " nonces: " << (identical ? "OUI" : "NON") << std::endl;
+    std::cout << "Stringstream + SHA-256 complet: " << (uint64_t)(SAMPLES / fullSeconds) << " H/s" << std::endl;
+    std::cout << "Midstate + queue pre-remplie: " << (uint64_t)(SAMPLES / midSeconds) << " H/s" << std::endl;
+    std::cout << "Acceleration: " << fullSeconds / midSeconds << "x" << std::endl << std::endl;
+
+    std::cout << "=== Test cibles de difficulte au bit pres ===" << std::endl;
+    std::cout << "Difficulte hex 3 = 12 bits: "
+              << (DifficultyTarget::fromHexZeros(3) == DifficultyTarget::fromLeadingZeroBits(12) ? "OUI" : "NON") << std::endl;
+    Blockchain bitChain;
+    for(int bits = 9; bits <= 15; bits += 3) {
+        DifficultyTarget target = DifficultyTarget::fromLeadingZeroBits(bits);
+        Block block(bitChain.getSize(), bitChain.getLastBlock().getHash(), "Bits " + std::to_string(bits));
+        block.mineBlock(target);
+        bitChain.addBlock(block);
+        Digest digest;
+        hexToDigest(block.getHash(), digest);
+        std::cout << bits << " bits (~" << (uint64_t)target.expectedHashes() << " hashes attendus): nonce "
+                  << block.getNonce() << ", " << leadingZeroBits(digest) << " bits a zero" << std::endl;
+    }
+    std::cout << "Chaine a cibles binaires valide: " << (bitChain.isChainValid() ? "OUI" : "NON") << std::endl;
+    std::cout << "Chaine historique toujours valide: " << (testChain.isChainValid() ? "OUI" : "NON") << std::endl;
+    Digest tooHigh;
+    hexToDigest(bitChain.getLastBlock().getHash(), tooHigh);
+    std::cout << "Hash au-dessus d'une cible plus basse rejete: "
+              << (!DifficultyTarget(Digest()).isMetBy(tooHigh) ? "OUI" : "NON") << std::endl << std::endl;
+
+    std::cout << "=== Simulation d'ajustement de la difficulte ===" << std::endl;
+    RetargetParams params(10.0, 20, DifficultyTarget::fromLeadingZeroBits(16));
+    std::vector<RetargetSimulation::Phase> profile = {{300, 1e6}, {300, 1e7}, {300, 5e5}};
+    RetargetSimulation::Report simulation = RetargetSimulation::run(params, profile);
+    std::cout << "Intervalle vise: " << params.blockSeconds << " s, fenetre: " << params.window << " blocs" << std::endl;
+    for(const RetargetSimulation::PhaseReport& phase : simulation.phases) {
+        std::cout << "  " << phase.hashesPerSecond << " H/s: converge en " << phase.blocksToConverge
+                  << " blocs, temps moyen ensuite " << phase.meanBlockSeconds << " s" << std::endl;
+    }
+    // Bitcoin-like parameters: 2016 blocks of 10 min take about 1.2e9 ms,
+    // and ten times too slow is clamped to a target 4 times easier
+    DifficultyRetargeter slow(RetargetParams(600.0, 2016, DifficultyTarget::fromLeadingZeroBits(20)));
+    for(int i = 0; i < 2016; i++) {
+        slow.recordBlock(i * 6000.0, DifficultyTarget::fromLeadingZeroBits(20));
+    }
+    double slowBits = slow.nextTarget().getDifficultyBits();
+    std::cout << "Fenetre de 2016 blocs de 600 s trop lents: " << slowBits << " bits au lieu de 20, "
+              << (std::fabs(slowBits - 18) < 0.01 ? "OUI" : "NON") << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "=== Test minage parallele ===" << std::endl;
+    ParallelMiner miner(4);
+    Block serial(4, testChain.getLastBlock().getHash(), "Transaction 4");
+    serial.mineBlock(4);
+    Block parallel(4, testChain.getLastBlock().getHash(), "Transaction 4");
+    MiningResult mined = parallel.mineBlockParallel(4, miner);
+
+    std::cout << "Threads: " << miner.getThreadCount() << std::endl;
+    for(size_t t = 0; t < mined.hashesPerThread.size(); t++) {
+        std::cout << "  Thread " << t << ": " << mined.hashesPerThread[t] << " hashes, "
+                  << (uint64_t)mined.threadHashRate(t) << " H/s" << std::endl;
+    }
+    std::cout << "Total: " << mined.totalHashes() << " hashes, " << (uint64_t)mined.hashRate() << " H/s" << std::endl;
+    std::cout << "Meme nonce que le minage sequentiel: "
+              << (mined.found && parallel.getNonce() == serial.getNonce() && parallel.getHash() == serial.getHash() ? "OUI" : "NON")
+              << std::endl;
+
+    std::atomic<bool> cancel(false);
+    std::thread canceller([&cancel]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        cancel.store(true);
+    });
+    Block abandoned(5, parallel.getHash(), "Transaction 5");
+    MiningResult stopped = abandoned.mineBlockParallel(8, miner, &cancel);
+    canceller.join();
+    std::cout << "Minage annule apres " << (long)(stopped.seconds * 1000) << " ms: "
+              << (stopped.cancelled && !stopped.found && abandoned.getNonce() == 0 ? "OUI" : "NON") << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "=== Test validation incrementale ===" << std::endl;
+    Blockchain longChain;
+    for(int i = 1; i <= 500; i++) {
+        Block block(i, longChain.getLastBlock().getHash(), "Transaction");
+        block.mineBlock(1);
+        longChain.addBlock(block);
+    }
+    auto startFull = std::chrono::high_resolution_clock::now();
+    bool fullValid = longChain.isChainValid();
+    auto endFull = std::chrono::high_resolution_clock::now();
+    Block tail(501, longChain.getLastBlock().getHash(), "Transaction");
+    tail.mineBlock(1);
+    longChain.addBlock(tail);
+    auto startTail = std::chrono::high_resolution_clock::now();
+    bool tailValid = longChain.isChainValid();
+    auto endTail = std::chrono::high_resolution_clock::now();
+    std::cout << "Validation complete: " << (fullValid ? "OUI" : "NON") << " en "
+              << std::chrono::duration_cast<std::chrono::microseconds>(endFull - startFull).count()
+              << " us, puis du seul nouveau bloc: " << (tailValid ? "OUI" : "NON") << " en "
+              << std::chrono::duration_cast<std::chrono::microseconds>(endTail - startTail).count() << " us" << std::endl;
+    std::cout << "Hauteur verifiee: " << longChain.getVerifiedHeight() << std::endl;
+
+    // A node starting from the same blocks trusts them up to a signed checkpoint
+    Blockchain restarted;
+    for(int i = 1; i < (int)longChain.getSize(); i++) {
+        restarted.addBlock(longChain.getBlock(i));
+    }
+    Ed25519Key authority = Ed25519Key::generate();
+    std::string checkpointHash = longChain.getBlock(480).getHash();
+    Signature checkpointSignature = Checkpoints::sign(authority, 480, checkpointHash);
+    std::cout << "Point de controle signe a la hauteur 480 accepte: "
+              << (restarted.addSignedCheckpoint(480, checkpointHash, checkpointSignature, authority.publicKey())
+                  ? "OUI" : "NON") << std::endl;
+    std::cout << "Meme signature pour une autre hauteur refusee: "
+              << (!restarted.addSignedCheckpoint(479, checkpointHash, checkpointSignature, authority.publicKey())
+                  ? "OUI" : "NON") << std::endl;
+    std::cout << "Chaine validee a partir du point de controle: "
+              << (restarted.isChainValid() && restarted.getVerifiedHeight() == restarted.getSize() ? "OUI" : "NON")
+              << std::endl;
+
+    Blockchain forked = restarted;
+    forked.addCheckpoint(100, longChain.getBlock(101).getHash());
+    std::cout << "Chaine contredisant un point de controle refusee: " << (!forked.isChainValid() ? "OUI" : "NON")
+              << std::endl;
 
     return 0;
 }
\ No newline at end of file
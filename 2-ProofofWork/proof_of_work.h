@@ -10,7 +10,17 @@
 #include <ctime>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 #include <openssl/sha.h>
+#include "../0-Common/checkpoints.h"
+#include "nonce_search.h"
+#include "parallel_miner.h"
+
+// Version 1 hashes index, previous hash, data, timestamp and nonce;
+// version 2 also hashes the target (hex) before the nonce, so the work a
+// block claims cannot be changed after mining
+const uint32_t POW_BLOCK_VERSION_LEGACY = 1;
+const uint32_t POW_BLOCK_VERSION_TARGET = 2;
 
 class Block {
 private:
@@ -18,10 +28,15 @@ private:
     std::string previousHash;
     std::string data;
     time_t timestamp;
-    int nonce;
+    // 64 bits: the decimal text preimage is the same as with the former int
+    // for every nonce below 2^31, so existing block hashes do not change
+    uint64_t nonce;
     std::string hash;
+    // Target the block was mined for
+    DifficultyTarget target;
+    uint32_t version;
 
-    std::string calculateHash(const std::string& input) {
+    std::string calculateHash(const std::string& input) const {
         unsigned char hash[SHA256_DIGEST_LENGTH];
         SHA256((unsigned char*)input.c_str(), input.size(), hash);
 
@@ -32,42 +47,91 @@ private:
         return ss.str();
     }
 
+    // Preimage up to the nonce, for a block mined for blockTarget
+    std::string hashPrefix(const DifficultyTarget& blockTarget) const {
+        std::stringstream ss;
+        ss << index << previousHash << data << timestamp;
+        if(version >= POW_BLOCK_VERSION_TARGET) {
+            ss << blockTarget.toHex();
+        }
+        return ss.str();
+    }
+
 public:
-    Block(int idx, const std::string& prevHash, const std::string& blockData)
-        : index(idx), previousHash(prevHash), data(blockData), nonce(0) {
+    Block(int idx, const std::string& prevHash, const std::string& blockData,
+          uint32_t blockVersion = POW_BLOCK_VERSION_TARGET)
+        : index(idx), previousHash(prevHash), data(blockData), nonce(0), version(blockVersion) {
         timestamp = time(nullptr);
         hash = "";
     }
 
+    // The nonce is the last field of the preimage, so candidates are
+    // hashed in multi-buffer batches
+    void mineBlock(const DifficultyTarget& blockTarget) {
+        target = blockTarget;
+        uint64_t found = 0;
+        if(findNonceBatched(hashPrefix(target), "", nonce, target, found, hash)) {
+            nonce = found;
+        }
+    }
+
+    // difficulty = number of leading '0' in the hex hash
     void mineBlock(int difficulty) {
-        std::string target(difficulty, '0');
+        mineBlock(DifficultyTarget::fromHexZeros(difficulty));
+    }
 
-        do {
-            nonce++;
-            hash = calculateBlockHash();
-        } while (hash.substr(0, difficulty) != target);
+    // Same result as mineBlock, searched by all the miner's threads.
+    // Leaves the block unchanged if cancel is raised before a solution is found.
+    MiningResult mineBlockParallel(const DifficultyTarget& blockTarget, ParallelMiner& miner,
+                                   const std::atomic<bool>* cancel = nullptr) {
+        std::string prefix = hashPrefix(blockTarget);
+
+        MiningResult result = miner.mine(
+                [&](uint64_t first, uint64_t last, uint64_t& found, std::string& foundHash, uint64_t& hashes) {
+                    return findNonceInRange(prefix, "", first, last, blockTarget, found, foundHash, hashes);
+                },
+                nonce + 1, UINT64_MAX, cancel);
+
+        if(result.found) {
+            nonce = result.nonce;
+            hash = result.hash;
+            target = blockTarget;
+        }
+        return result;
     }
 
-    std::string calculateBlockHash() {
+    MiningResult mineBlockParallel(int difficulty, ParallelMiner& miner,
+                                   const std::atomic<bool>* cancel = nullptr) {
+        return mineBlockParallel(DifficultyTarget::fromHexZeros(difficulty), miner, cancel);
+    }
+
+    std::string calculateBlockHash() const {
         std::stringstream ss;
-        ss << index << previousHash << data << timestamp << nonce;
+        ss << hashPrefix(target) << nonce;
         return calculateHash(ss.str());
     }
 
-    std::string getHash() const { return hash; }
+    const std::string& getHash() const { return hash; }
     int getIndex() const { return index; }
-    std::string getPreviousHash() const { return previousHash; }
-    std::string getData() const { return data; }
+    const std::string& getPreviousHash() const { return previousHash; }
+    const std::string& getData() const { return data; }
     time_t getTimestamp() const { return timestamp; }
-    int getNonce() const { return nonce; }
+    uint64_t getNonce() const { return nonce; }
+    const DifficultyTarget& getTarget() const { return target; }
+    uint32_t getVersion() const { return version; }
+    bool meetsTarget() const { return target.isMetByHex(hash); }
 };
 
 class Blockchain {
 private:
     std::vector<Block> chain;
+    // Blocks below it passed isChainValid; blocks are never modified, so
+    // they need not be checked again
+    size_t verifiedHeight;
+    Checkpoints checkpoints;
 
 public:
-    Blockchain() {
+    Blockchain() : verifiedHeight(1) {
         chain.push_back(createGenesisBlock());
     }
 
@@ -77,33 +141,62 @@ public:
         return genesis;
     }
 
-    Block getLastBlock() {
+    const Block& getLastBlock() const {
         return chain.back();
     }
 
     void addBlock(Block newBlock) {
-        chain.push_back(newBlock);
+        chain.push_back(std::move(newBlock));
     }
 
+    // Checks the blocks above the verified height and the last checkpoint
     bool isChainValid() {
-        for(size_t i = 1; i < chain.size(); i++) {
-            Block currentBlock = chain[i];
-            Block previousBlock = chain[i - 1];
+        uint64_t trusted;
+        if(!checkpoints.trustedPrefix(chain.size(), [this](uint64_t h) -> const std::string& { return chain[h].getHash(); },
+                                      trusted)) {
+            return false;
+        }
+        for(size_t i = std::max<size_t>(verifiedHeight, trusted); i < chain.size(); i++) {
+            const Block& currentBlock = chain[i];
+            const Block& previousBlock = chain[i - 1];
 
             if(currentBlock.getHash() != currentBlock.calculateBlockHash()) {
                 return false;
             }
 
+            if(!currentBlock.meetsTarget()) {
+                return false;
+            }
+
             if(currentBlock.getPreviousHash() != previousBlock.getHash()) {
                 return false;
             }
         }
+        verifiedHeight = chain.size();
         return true;
     }
 
+    // Blocks up to a checkpoint matched by the chain are not validated
+    void addCheckpoint(uint64_t height, const std::string& hash) { checkpoints.add(height, hash); }
+
+    // Returns false if the signature of authority does not verify
+    bool addSignedCheckpoint(uint64_t height, const std::string& hash, const Signature& signature,
+                             const PublicKey& authority) {
+        return checkpoints.addSigned(height, hash, signature, authority);
+    }
+
+    // Blocks below it are known to be valid
+    size_t getVerifiedHeight() const { return verifiedHeight; }
+
+    // Makes the next isChainValid check the blocks from height on again;
+    // those up to a matched checkpoint stay trusted
+    void resetVerifiedHeight(size_t height = 1) {
+        verifiedHeight = std::min(verifiedHeight, std::max<size_t>(height, 1));
+    }
+
     size_t getSize() const { return chain.size(); }
 
-    Block getBlock(int index) const { return chain[index]; }
+    const Block& getBlock(int index) const { return chain[index]; }
 };
 
 
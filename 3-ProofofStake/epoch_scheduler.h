@@ -0,0 +1,165 @@
+//
+// Created by abdelaziz on 10/17/2026.
+//
+
+#ifndef IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_EPOCH_SCHEDULER_H
+#define IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_EPOCH_SCHEDULER_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+#include "leader_election.h"
+
+// Proposers and committees of every slot of one epoch, drawn from the
+// validators frozen at the start of the epoch
+struct EpochSchedule {
+    uint64_t epoch;
+    uint64_t firstSlot;
+    uint64_t slotCount;
+    size_t committeeSize;
+    std::string seed;
+    ValidatorSnapshot validators;
+    // Per slot: proposer then committeeSize members, as indices into
+    // validators.getValidators(); empty if nobody had stake
+    std::vector<uint32_t> drawn;
+
+    explicit EpochSchedule(const ValidatorSnapshot& set)
+            : epoch(0), firstSlot(0), slotCount(0), committeeSize(0), validators(set) {}
+
+    bool contains(uint64_t slot) const { return slot >= firstSlot && slot - firstSlot < slotCount; }
+
+    // "" if nobody had stake
+    std::string proposer(uint64_t slot) const {
+        if(drawn.empty()) {
+            return "";
+        }
+        return validators.getValidators()[drawn[(slot - firstSlot) * (committeeSize + 1)]].address;
+    }
+
+    // Drawn with replacement: a validator can hold several seats
+    std::vector<std::string> committee(uint64_t slot) const {
+        std::vector<std::string> members;
+        if(drawn.empty()) {
+            return members;
+        }
+        size_t first = (slot - firstSlot) * (committeeSize + 1) + 1;
+        for(size_t j = 0; j < committeeSize; j++) {
+            members.push_back(validators.getValidators()[drawn[first + j]].address);
+        }
+        return members;
+    }
+
+    // Slots of the epoch this validator proposes, known before the epoch starts
+    std::vector<uint64_t> slotsOf(const std::string& address) const {
+        std::vector<uint64_t> slots;
+        for(uint64_t s = 0; s < slotCount && !drawn.empty(); s++) {
+            if(validators.getValidators()[drawn[s * (committeeSize + 1)]].address == address) {
+                slots.push_back(firstSlot + s);
+            }
+        }
+        return slots;
+    }
+};
+
+// Builds the schedule of a whole epoch at once and caches it, so that
+// choosing or checking the proposer of a block is a table lookup.
+//
+// Ticket k of slot s is SHA256(seed || s as 8 bytes || k as 4 bytes) mod
+// the total stake, k = 0 for the proposer and 1..committeeSize for the
+// committee. The seed is the hash of the last block before the epoch.
+// All tickets of the epoch are sorted and matched against the cumulative
+// stakes in one pass over the validators: O(n + m log m) for m tickets,
+// instead of m tree walks of O(log n) cache misses each.
+class EpochScheduler {
+private:
+    uint64_t slotsPerEpoch;
+    size_t committeeSize;
+    std::map<uint64_t, EpochSchedule> cache;
+
+    static uint64_t ticket(const std::string& seed, uint64_t slot, uint32_t seat, uint64_t totalStake) {
+        std::string input = seed;
+        for(int shift = 56; shift >= 0; shift -= 8) {
+            input.push_back((char)(uint8_t)(slot >> shift));
+        }
+        for(int shift = 24; shift >= 0; shift -= 8) {
+            input.push_back((char)(uint8_t)(seat >> shift));
+        }
+        return leaderTicket(sha256Digest(input), totalStake);
+    }
+
+public:
+    explicit EpochScheduler(uint64_t slots = 32, size_t committee = 4)
+            : slotsPerEpoch(slots), committeeSize(committee) {}
+
+    static EpochSchedule compute(const ValidatorSnapshot& validators, const std::string& seed, uint64_t epoch,
+                                 uint64_t slots, size_t committee) {
+        EpochSchedule schedule(validators);
+        schedule.epoch = epoch;
+        schedule.firstSlot = epoch * slots;
+        schedule.slotCount = slots;
+        schedule.committeeSize = committee;
+        schedule.seed = seed;
+        uint64_t total = validators.totalStake();
+        if(total == 0) {
+            return schedule;
+        }
+
+        size_t seats = committee + 1;
+        std::vector<std::pair<uint64_t, uint32_t> > tickets(slots * seats);
+        for(uint64_t s = 0; s < slots; s++) {
+            for(size_t k = 0; k < seats; k++) {
+                size_t position = s * seats + k;
+                tickets[position] = std::make_pair(ticket(seed, schedule.firstSlot + s, (uint32_t)k, total),
+                                                   (uint32_t)position);
+            }
+        }
+        std::sort(tickets.begin(), tickets.end());
+
+        const StakeIndex& stakes = validators.getStakeIndex();
+        schedule.drawn.resize(tickets.size());
+        size_t v = 0;
+        uint64_t cumulative = stakes.getStake(0);
+        for(size_t t = 0; t < tickets.size(); t++) {
+            while(cumulative <= tickets[t].first) {
+                cumulative += stakes.getStake(++v);
+            }
+            schedule.drawn[tickets[t].second] = (uint32_t)v;
+        }
+        return schedule;
+    }
+
+    uint64_t epochOf(uint64_t slot) const { return slot / slotsPerEpoch; }
+    uint64_t getSlotsPerEpoch() const { return slotsPerEpoch; }
+    size_t getCommitteeSize() const { return committeeSize; }
+
+    // Computed on first use with these validators and seed, then cached:
+    // later calls with the same seed get the same schedule whatever
+    // validators they pass, since stake changes wait for the next epoch.
+    // Another seed (the seed block was replaced) recomputes the schedule
+    // and replaces the cached one.
+    const EpochSchedule& schedule(uint64_t epoch, const ValidatorSnapshot& validators, const std::string& seed) {
+        std::map<uint64_t, EpochSchedule>::iterator it = cache.find(epoch);
+        if(it == cache.end()) {
+            it = cache.insert(std::make_pair(epoch, compute(validators, seed, epoch, slotsPerEpoch, committeeSize))).first;
+        } else if(it->second.seed != seed) {
+            it->second = compute(validators, seed, epoch, slotsPerEpoch, committeeSize);
+        }
+        return it->second;
+    }
+
+    // nullptr if the epoch was never scheduled
+    const EpochSchedule* find(uint64_t epoch) const {
+        std::map<uint64_t, EpochSchedule>::const_iterator it = cache.find(epoch);
+        return it == cache.end() ? nullptr : &it->second;
+    }
+
+    // Drops the schedules of epochs before epoch
+    void prune(uint64_t epoch) {
+        cache.erase(cache.begin(), cache.lower_bound(epoch));
+    }
+};
+
+#endif //IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_EPOCH_SCHEDULER_H
@@ -0,0 +1,70 @@
+//
+// Created by abdelaziz on 10/17/2026.
+//
+
+#ifndef IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_LEADER_ELECTION_H
+#define IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_LEADER_ELECTION_H
+
+#include <string>
+#include <cstdint>
+#include "../0-Common/digest.h"
+#include "validator_registry.h"
+
+// Proposer of a slot, derived only from chain data so that every node gets
+// the same answer: seed = SHA256(previous block hash || slot as 8
+// big-endian bytes), read as a 256-bit number and reduced modulo the total
+// stake. The validator owning that ticket in the stake distribution is the
+// leader: O(log n) with the Fenwick tree, and independent for each block,
+// so a chain can be checked block by block in any order.
+
+inline Digest leaderSeed(const std::string& previousHash, uint64_t slot) {
+    std::string input = previousHash;
+    for(int shift = 56; shift >= 0; shift -= 8) {
+        input.push_back((char)(uint8_t)(slot >> shift));
+    }
+    return sha256Digest(input);
+}
+
+// seed mod totalStake. Up to 2^32 of total stake, 32 bits at a time;
+// above, one bit at a time so that no step overflows.
+inline uint64_t leaderTicket(const Digest& seed, uint64_t totalStake) {
+    uint64_t remainder = 0;
+    if(totalStake <= 0x100000000ULL) {
+        for(size_t i = 0; i < seed.size(); i += 4) {
+            uint64_t limb = ((uint64_t)seed[i] << 24) | ((uint64_t)seed[i + 1] << 16)
+                            | ((uint64_t)seed[i + 2] << 8) | seed[i + 3];
+            remainder = ((remainder << 32) | limb) % totalStake;
+        }
+        return remainder;
+    }
+    for(size_t i = 0; i < seed.size(); i++) {
+        for(int bit = 7; bit >= 0; bit--) {
+            remainder = remainder >= totalStake - remainder ? remainder - (totalStake - remainder) : remainder * 2;
+            if((seed[i] >> bit) & 1) {
+                remainder = remainder + 1 == totalStake ? 0 : remainder + 1;
+            }
+        }
+    }
+    return remainder;
+}
+
+// The seed as a number in [0, 1), for stakes that are not integers
+inline double leaderFraction(const Digest& seed) {
+    uint64_t high = 0;
+    for(size_t i = 0; i < 8; i++) {
+        high = (high << 8) | seed[i];
+    }
+    return (high >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// "" if no validator has stake
+inline std::string electLeader(const ValidatorSnapshot& validators, const std::string& previousHash, uint64_t slot) {
+    uint64_t total = validators.totalStake();
+    if(total == 0) {
+        return "";
+    }
+    size_t index = validators.getStakeIndex().find(leaderTicket(leaderSeed(previousHash, slot), total));
+    return validators.getValidators()[index].address;
+}
+
+#endif //IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_LEADER_ELECTION_H
@@ -43,6 +43,158 @@ int main() {
     std::cout << std::endl << "Temps d'execution PoS: " << durationPoS.count() << " microseconds" << std::endl;
     std::cout << "Chaine PoS valide: " << (blockchainPoS.isChainValid() ? "OUI" : "NON") << std::endl;
 
+    std::cout << std::endl << "=== Election deterministe du proposant ===" << std::endl << std::endl;
+
+    // Another node with the same validators re-derives every proposer from the chain alone
+    ValidatorRegistry otherNode;
+    otherNode.bond("Validator_A", 100);
+    otherNode.bond("Validator_B", 200);
+    otherNode.bond("Validator_C", 50);
+    otherNode.bond("Validator_D", 150);
+    EpochSchedule recomputed = EpochScheduler::compute(otherNode.snapshot(), blockchainPoS.getBlock(0).getHash(), 0, 32, 4);
+    bool sameProposers = true;
+    for(size_t i = 1; i < blockchainPoS.getSize(); i++) {
+        sameProposers = sameProposers && recomputed.proposer(i) == blockchainPoS.getBlock(i).getValidator();
+    }
+    std::cout << "Proposants re-derives par un autre noeud: " << (sameProposers ? "OUI" : "NON") << std::endl;
+
+    // Epoch 1 starts at slot 32; its seed is the hash of block 31
+    for(int i = (int)blockchainPoS.getSize(); i < 32; i++) {
+        blockchainPoS.addBlock(BlockPoS(i, blockchainPoS.getLastBlock().getHash(), "Block PoS"));
+    }
+    const EpochSchedule& next = *blockchainPoS.getEpochSchedule(1);
+    std::cout << "Planning de l'epoque 2 refuse avant son bloc graine: "
+              << (blockchainPoS.getEpochSchedule(2) == nullptr ? "OUI" : "NON") << std::endl;
+    std::cout << "Bloc pour un slot futur refuse: "
+              << (!blockchainPoS.addBlock(BlockPoS(40, blockchainPoS.getLastBlock().getHash(), "Block PoS"))
+                  && blockchainPoS.getSize() == 32 ? "OUI" : "NON") << std::endl;
+    std::cout << "Slots de Validator_C a l'epoque 1:";
+    for(uint64_t slot : next.slotsOf("Validator_C")) {
+        std::cout << " " << slot;
+    }
+    std::cout << std::endl;
+    std::cout << "Comite du slot 32:";
+    for(const auto& member : next.committee(32)) {
+        std::cout << " " << member;
+    }
+    std::cout << std::endl;
+    for(int i = 32; i < 64; i++) {
+        blockchainPoS.addBlock(BlockPoS(i, blockchainPoS.getLastBlock().getHash(), "Block PoS"));
+    }
+    bool followsSchedule = true;
+    for(int i = 32; i < 64; i++) {
+        followsSchedule = followsSchedule && blockchainPoS.getBlock(i).getValidator() == next.proposer(i);
+    }
+    std::cout << "Blocs de l'epoque 1 produits selon le planning: " << (followsSchedule ? "OUI" : "NON") << std::endl;
+    std::cout << "Chaine PoS sur deux epoques valide: " << (blockchainPoS.isChainValid() ? "OUI" : "NON") << std::endl;
+
+    const int SLOTS = 20000;
+    std::map<std::string, int> elected;
+    EpochSchedule longEpoch = EpochScheduler::compute(otherNode.snapshot(), blockchainPoS.getLastBlock().getHash(), 0,
+                                                      SLOTS, 0);
+    for(int slot = 0; slot < SLOTS; slot++) {
+        elected[longEpoch.proposer(slot)]++;
+    }
+    std::cout << "Part des slots sur " << SLOTS << " (stake attendu A 0.20, B 0.40, C 0.10, D 0.30):";
+    for(const auto& e : elected) {
+        std::cout << " " << e.first.substr(10) << " " << std::fixed << std::setprecision(3) << (double)e.second / SLOTS;
+    }
+    std::cout << std::endl;
+
+    std::cout << std::endl << "=== Selection ponderee a grande echelle ===" << std::endl << std::endl;
+
+    // 100000 validators, 3e9 each for the first ten: the total is far above INT_MAX
+    ProofOfStake large;
+    const int VALIDATORS = 100000;
+    for(int i = 0; i < VALIDATORS; i++) {
+        std::stringstream ss;
+        ss << "V" << i;
+        large.addValidator(ss.str(), i < 10 ? 3000000000ULL : 1000 + i % 5000);
+    }
+    large.getRegistry().unbond("V1", 3000000000ULL, 1);
+    large.getRegistry().bond("V2", 3000000000ULL);
+
+    const int DRAWS = 200000;
+    for(int mode = 0; mode < 2; mode++) {
+        if(mode == 1) {
+            large.freezeStakes();
+        }
+        std::map<std::string, int> counts;
+        auto startSelect = std::chrono::high_resolution_clock::now();
+        for(int d = 0; d < DRAWS; d++) {
+            counts[large.selectValidator()]++;
+        }
+        auto endSelect = std::chrono::high_resolution_clock::now();
+        double share0 = (double)large.getValidator(0).stake / large.getTotalStake();
+        double share2 = (double)large.getValidator(2).stake / large.getTotalStake();
+        std::cout << (mode == 0 ? "Arbre de Fenwick" : "Table d'alias") << ": "
+                  << std::chrono::duration_cast<std::chrono::nanoseconds>(endSelect - startSelect).count() / DRAWS
+                  << " ns par selection" << std::endl;
+        std::cout << "  V0 attendu " << std::fixed << std::setprecision(3) << share0 << ", observe "
+                  << (double)counts["V0"] / DRAWS << std::endl;
+        std::cout << "  V2 attendu " << share2 << ", observe " << (double)counts["V2"] / DRAWS << std::endl;
+        std::cout << "  Stake nul jamais choisi: " << (counts.count("V1") == 0 ? "OUI" : "NON") << std::endl;
+    }
+
+    std::cout << std::endl << "=== Registre des validateurs ===" << std::endl << std::endl;
+
+    ValidatorRegistry registry;
+    registry.bond("Alice", 1000);
+    registry.bond("Bob", 500);
+    registry.bond("Alice", 200);
+    ValidatorSnapshot epoch0 = registry.snapshot();
+
+    registry.unbond("Bob", 300, 2);
+    uint64_t burnt = registry.slash("Bob", 5000);
+    std::cout << "Alice: " << registry.getStake("Alice") << ", Bob: " << registry.getStake("Bob")
+              << " (en sortie: " << registry.find("Bob")->unbonding << ", brule: " << burnt << ")" << std::endl;
+    std::cout << "Rien a liberer a l'epoque 1: " << (registry.releaseUnbonded(1).empty() ? "OUI" : "NON") << std::endl;
+    std::vector<Unbonding> released = registry.releaseUnbonded(2);
+    std::cout << "Libere a l'epoque 2: " << (released.size() == 1 ? released[0].amount : 0) << std::endl;
+    std::cout << "Snapshot de l'epoque 0 inchange: "
+              << (epoch0.getStake("Alice") == 1200 && epoch0.getStake("Bob") == 500 && epoch0.totalStake() == 1700
+                  ? "OUI" : "NON") << std::endl;
+    std::cout << "Index de selection synchronise: "
+              << (registry.totalStake() == registry.getStake("Alice") + registry.getStake("Bob") ? "OUI" : "NON") << std::endl;
+
+    std::cout << std::endl << "=== Signatures des blocs ===" << std::endl << std::endl;
+
+    SignatureVerifier& verifier = blockchainPoS.getVerifier();
+    BlockPoS signedBlock = blockchainPoS.getLastBlock();
+    const ValidatorRecord* signer = blockchainPoS.getPoS().getRegistry().find(signedBlock.getValidator());
+    SignatureCheck forged = signedBlock.signatureCheck(signer->publicKey);
+    std::cout << "Signature du dernier bloc valide: "
+              << (ed25519Verify(forged.publicKey, forged.message.data(), forged.message.size(), forged.signature)
+                  ? "OUI" : "NON") << std::endl;
+
+    forged.signature[0] ^= 1;
+    std::cout << "Signature modifiee refusee: " << (!verifier.verify(forged) ? "OUI" : "NON") << std::endl;
+    forged.signature[0] ^= 1;
+    forged.message[0] ^= 1;
+    std::cout << "Signature d'un autre bloc refusee: " << (!verifier.verify(forged) ? "OUI" : "NON") << std::endl;
+
+    // Only the blocks added since the last validation are checked again
+    size_t verifiedBefore = blockchainPoS.getVerifiedHeight();
+    size_t cachedBefore = verifier.getCacheSize();
+    for(int i = 0; i < 3; i++) {
+        blockchainPoS.addBlock(BlockPoS(blockchainPoS.getSize(), blockchainPoS.getLastBlock().getHash(), "Block PoS"));
+    }
+    auto startRevalidate = std::chrono::high_resolution_clock::now();
+    bool revalidated = blockchainPoS.isChainValid();
+    auto endRevalidate = std::chrono::high_resolution_clock::now();
+    std::cout << "Revalidation apres 3 blocs: " << (revalidated ? "OUI" : "NON") << ", blocs " << verifiedBefore
+              << " a " << blockchainPoS.getVerifiedHeight() - 1 << ", " << verifier.getCacheSize() - cachedBefore
+              << " signatures verifiees, "
+              << std::chrono::duration_cast<std::chrono::microseconds>(endRevalidate - startRevalidate).count()
+              << " us" << std::endl;
+
+    blockchainPoS.setVerifyThreads(4);
+    for(int i = 0; i < 3; i++) {
+        blockchainPoS.addBlock(BlockPoS(blockchainPoS.getSize(), blockchainPoS.getLastBlock().getHash(), "Block PoS"));
+    }
+    std::cout << "Validation sur 4 threads: " << (blockchainPoS.isChainValid() ? "OUI" : "NON") << std::endl;
+    blockchainPoS.setVerifyThreads(1);
+
     std::cout << std::endl << "=== Comparaison PoW vs PoS ===" << std::endl << std::endl;
 
     int difficulty = 3;
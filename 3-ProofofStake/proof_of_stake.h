@@ -13,13 +13,21 @@
 #include <iomanip>
 #include <openssl/sha.h>
 #include <random>
+#include <cstdint>
+#include <memory>
+#include <algorithm>
+#include "../0-Common/ed25519.h"
+#include "../0-Common/checkpoints.h"
+#include "validator_registry.h"
+#include "leader_election.h"
+#include "epoch_scheduler.h"
 
 class Validator {
 public:
     std::string address;
-    int stake;
+    uint64_t stake;
 
-    Validator(const std::string& addr, int stakeAmount)
+    Validator(const std::string& addr, uint64_t stakeAmount)
         : address(addr), stake(stakeAmount) {}
 };
 
@@ -31,8 +39,10 @@ private:
     time_t timestamp;
     std::string hash;
     std::string validatorAddress;
+    // Validator's Ed25519 signature of the hash, not part of it
+    Signature signature;
 
-    std::string calculateHash(const std::string& input) {
+    std::string calculateHash(const std::string& input) const {
         unsigned char hash[SHA256_DIGEST_LENGTH];
         SHA256((unsigned char*)input.c_str(), input.size(), hash);
 
@@ -48,6 +58,7 @@ public:
         : index(idx), previousHash(prevHash), data(blockData), validatorAddress("") {
         timestamp = time(nullptr);
         hash = "";
+        signature.fill(0);
     }
 
     void validateBlock(const std::string& validator) {
@@ -55,68 +66,114 @@ public:
         hash = calculateBlockHash();
     }
 
-    std::string calculateBlockHash() {
+    // After validateBlock, with the validator's key; a block without a
+    // hash is left unsigned
+    void sign(const Ed25519Key& key) {
+        Digest digest;
+        if(!hexToDigest(hash, digest)) {
+            signature.fill(0);
+            return;
+        }
+        signature = key.sign(digest);
+    }
+
+    // Check of the signature against publicKey; the message is the hash
+    SignatureCheck signatureCheck(const PublicKey& publicKey) const {
+        SignatureCheck check;
+        check.publicKey = publicKey;
+        check.signature = signature;
+        if(!hexToDigest(hash, check.message)) {
+            check.message.fill(0);
+        }
+        return check;
+    }
+
+    std::string calculateBlockHash() const {
         std::stringstream ss;
         ss << index << previousHash << data << timestamp << validatorAddress;
         return calculateHash(ss.str());
     }
 
-    std::string getHash() const { return hash; }
+    const std::string& getHash() const { return hash; }
     int getIndex() const { return index; }
-    std::string getPreviousHash() const { return previousHash; }
-    std::string getData() const { return data; }
+    const std::string& getPreviousHash() const { return previousHash; }
+    const std::string& getData() const { return data; }
     time_t getTimestamp() const { return timestamp; }
-    std::string getValidator() const { return validatorAddress; }
+    const std::string& getValidator() const { return validatorAddress; }
+    const Signature& getSignature() const { return signature; }
 };
 
 class ProofOfStake {
 private:
-    std::vector<Validator> validators;
-    std::mt19937 rng;
+    ValidatorRegistry registry;
+    std::mt19937_64 rng;
 
 public:
     ProofOfStake() : rng(std::random_device{}()) {}
 
-    void addValidator(const std::string& address, int stake) {
-        validators.push_back(Validator(address, stake));
+    // A validator added twice has its stakes added up
+    void addValidator(const std::string& address, uint64_t stake) {
+        registry.bond(address, stake);
     }
 
+    // O(1) selection while stakes do not change (an epoch); any registry
+    // change goes back to the O(log n) tree
+    void freezeStakes() { registry.freeze(); }
+
+    // Probability proportional to stake, O(log n); "" if no stake at all
     std::string selectValidator() {
-        if(validators.empty()) {
-            return "";
-        }
+        return registry.sample(rng);
+    }
 
-        int totalStake = 0;
-        for(const auto& v : validators) {
-            totalStake += v.stake;
-        }
+    // Same distribution, but the proposer of the block after previousHash
+    // at slot is the same on every node (see leader_election.h)
+    std::string electValidator(const std::string& previousHash, uint64_t slot) const {
+        return electLeader(registry.snapshot(), previousHash, slot);
+    }
 
-        std::uniform_int_distribution<int> dist(0, totalStake - 1);
-        int randomValue = dist(rng);
+    uint64_t getTotalStake() const { return registry.totalStake(); }
 
-        int cumulativeStake = 0;
-        for(const auto& v : validators) {
-            cumulativeStake += v.stake;
-            if(randomValue < cumulativeStake) {
-                return v.address;
-            }
-        }
+    int getValidatorCount() const { return registry.size(); }
 
-        return validators[0].address;
+    Validator getValidator(int index) const {
+        const ValidatorRecord& record = registry.getValidator(index);
+        return Validator(record.address, record.stake);
     }
 
-    int getValidatorCount() const { return validators.size(); }
-
-    Validator getValidator(int index) const { return validators[index]; }
+    // Stake changes, unbonding and slashing
+    ValidatorRegistry& getRegistry() { return registry; }
 };
 
 class BlockchainPoS {
 private:
     std::vector<BlockPoS> chain;
     ProofOfStake pos;
+    // Proposers come from the schedule of their epoch; the slot of a block
+    // is its index
+    EpochScheduler scheduler;
+    // Keys of the validators this node signs for
+    std::map<std::string, Ed25519Key> signingKeys;
+    std::shared_ptr<SignatureVerifier> verifier;
+    // Blocks below it passed isChainValid
+    size_t verifiedHeight;
+    Checkpoints checkpoints;
+
+    // Hash of the last block before the epoch (the genesis for epoch 0);
+    // false if that block is not in the chain yet
+    bool epochSeed(uint64_t epoch, std::string& seed) const {
+        uint64_t first = epoch * scheduler.getSlotsPerEpoch();
+        uint64_t seedBlock = first == 0 ? 0 : first - 1;
+        if(first / scheduler.getSlotsPerEpoch() != epoch || seedBlock >= chain.size()) {
+            return false;
+        }
+        seed = chain[seedBlock].getHash();
+        return true;
+    }
 
 public:
-    BlockchainPoS() {
+    explicit BlockchainPoS(uint64_t slotsPerEpoch = 32, size_t committeeSize = 4)
+            : scheduler(slotsPerEpoch, committeeSize), verifier(std::make_shared<SignatureVerifier>()),
+              verifiedHeight(1) {
         chain.push_back(createGenesisBlock());
     }
 
@@ -126,24 +183,72 @@ public:
         return genesis;
     }
 
-    BlockPoS getLastBlock() {
+    const BlockPoS& getLastBlock() const {
         return chain.back();
     }
 
-    void addValidator(const std::string& address, int stake) {
+    // Stake changes take effect from the next epoch. The validator gets a
+    // new key pair, kept by this node to sign its blocks.
+    void addValidator(const std::string& address, uint64_t stake) {
+        addValidator(address, stake, Ed25519Key::generate());
+    }
+
+    void addValidator(const std::string& address, uint64_t stake, const Ed25519Key& key) {
         pos.addValidator(address, stake);
+        pos.getRegistry().setPublicKey(address, key.publicKey());
+        signingKeys[address] = key;
     }
 
-    void addBlock(BlockPoS newBlock) {
-        std::string validator = pos.selectValidator();
-        newBlock.validateBlock(validator);
-        chain.push_back(newBlock);
+    // Threads verifying block signatures in isChainValid
+    void setVerifyThreads(unsigned threads) { verifier->setThreadCount(threads); }
+
+    SignatureVerifier& getVerifier() { return *verifier; }
+
+    // Schedule of the epoch, computed with the current validators the first
+    // time it is asked for. nullptr until its seed block is in the chain, so
+    // the latest is the epoch after the one of the last block.
+    const EpochSchedule* getEpochSchedule(uint64_t epoch) {
+        std::string seed;
+        if(!epochSeed(epoch, seed)) {
+            return nullptr;
+        }
+        return &scheduler.schedule(epoch, pos.getRegistry().snapshot(), seed);
+    }
+
+    // Returns false, leaving the chain unchanged, if newBlock.getIndex() is
+    // not getSize() or the epoch of its slot has no seed yet
+    bool addBlock(BlockPoS newBlock) {
+        if(newBlock.getIndex() != (int)chain.size()) {
+            return false;
+        }
+        uint64_t slot = newBlock.getIndex();
+        const EpochSchedule* schedule = getEpochSchedule(scheduler.epochOf(slot));
+        if(schedule == nullptr) {
+            return false;
+        }
+        newBlock.validateBlock(schedule->proposer(slot));
+        std::map<std::string, Ed25519Key>::const_iterator key = signingKeys.find(newBlock.getValidator());
+        if(key != signingKeys.end()) {
+            newBlock.sign(key->second);
+        }
+        chain.push_back(std::move(newBlock));
+        return true;
     }
 
+    // Checks the blocks above the verified height and the last checkpoint:
+    // recomputes the schedules of their epochs from the validators and
+    // seeds, then verifies their signatures in one batch
     bool isChainValid() {
-        for(size_t i = 1; i < chain.size(); i++) {
-            BlockPoS currentBlock = chain[i];
-            BlockPoS previousBlock = chain[i - 1];
+        uint64_t trusted;
+        if(!checkpoints.trustedPrefix(chain.size(), [this](uint64_t h) -> const std::string& { return chain[h].getHash(); },
+                                      trusted)) {
+            return false;
+        }
+        EpochScheduler replay(scheduler.getSlotsPerEpoch(), scheduler.getCommitteeSize());
+        std::vector<SignatureCheck> signatures;
+        for(size_t i = std::max<size_t>(verifiedHeight, trusted); i < chain.size(); i++) {
+            const BlockPoS& currentBlock = chain[i];
+            const BlockPoS& previousBlock = chain[i - 1];
 
             if(currentBlock.getHash() != currentBlock.calculateBlockHash()) {
                 return false;
@@ -152,13 +257,52 @@ public:
             if(currentBlock.getPreviousHash() != previousBlock.getHash()) {
                 return false;
             }
+
+            uint64_t epoch = scheduler.epochOf(i);
+            const EpochSchedule* used = scheduler.find(epoch);
+            std::string seed;
+            if(used == nullptr || !epochSeed(epoch, seed)
+               || currentBlock.getValidator() != replay.schedule(epoch, used->validators, seed).proposer(i)) {
+                return false;
+            }
+
+            // Blocks of slots nobody could propose carry no signature
+            if(!currentBlock.getValidator().empty()) {
+                const ValidatorRecord* proposer = used->validators.find(currentBlock.getValidator());
+                if(proposer == nullptr || !proposer->hasPublicKey()) {
+                    return false;
+                }
+                signatures.push_back(currentBlock.signatureCheck(proposer->publicKey));
+            }
         }
+        if(!verifier->verifyBatch(signatures)) {
+            return false;
+        }
+        verifiedHeight = chain.size();
         return true;
     }
 
+    // Blocks up to a checkpoint matched by the chain are not validated
+    void addCheckpoint(uint64_t height, const std::string& hash) { checkpoints.add(height, hash); }
+
+    // Returns false if the signature of authority does not verify
+    bool addSignedCheckpoint(uint64_t height, const std::string& hash, const Signature& signature,
+                             const PublicKey& authority) {
+        return checkpoints.addSigned(height, hash, signature, authority);
+    }
+
+    // Blocks below it are known to be valid
+    size_t getVerifiedHeight() const { return verifiedHeight; }
+
+    // Makes the next isChainValid check the blocks from height on again;
+    // those up to a matched checkpoint stay trusted
+    void resetVerifiedHeight(size_t height = 1) {
+        verifiedHeight = std::min(verifiedHeight, std::max<size_t>(height, 1));
+    }
+
     size_t getSize() const { return chain.size(); }
 
-    BlockPoS getBlock(int index) const { return chain[index]; }
+    const BlockPoS& getBlock(int index) const { return chain[index]; }
 
     ProofOfStake& getPoS() { return pos; }
 };
@@ -0,0 +1,152 @@
+//
+// Created by abdelaziz on 10/17/2026.
+//
+
+#ifndef IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_STAKE_INDEX_H
+#define IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_STAKE_INDEX_H
+
+#include <vector>
+#include <random>
+#include <cstdint>
+#include <cstddef>
+
+// Stake-weighted sampling over validators 0..n-1.
+//
+// Stakes live in a Fenwick tree: adding a validator, changing a stake and
+// drawing one are all O(log n), and the total is kept as it changes. Stakes
+// and sums are 64-bit; the total must stay below 2^64.
+//
+// freeze() builds an alias table (Vose) on top, for epochs where the stakes
+// do not move: sampling is then O(1), two random numbers and one lookup.
+// Any stake change thaws the index back to the tree.
+class StakeIndex {
+private:
+    std::vector<uint64_t> stakes;
+    std::vector<uint64_t> tree;     // 1-based, tree[i] = sum of stakes (i - lowbit(i), i]
+    uint64_t total;
+
+    bool frozen;
+    std::vector<double> aliasProbability;
+    std::vector<uint32_t> alias;
+
+    static size_t lowbit(size_t i) { return i & (~i + 1); }
+
+    void buildAlias() {
+        size_t n = stakes.size();
+        aliasProbability.assign(n, 1.0);
+        alias.resize(n);
+        for(size_t i = 0; i < n; i++) {
+            alias[i] = (uint32_t)i;
+        }
+
+        // Scaled so that the average bucket holds exactly 1
+        std::vector<double> scaled(n);
+        std::vector<uint32_t> small;
+        std::vector<uint32_t> large;
+        for(size_t i = 0; i < n; i++) {
+            scaled[i] = (double)stakes[i] * n / total;
+            (scaled[i] < 1.0 ? small : large).push_back((uint32_t)i);
+        }
+        while(!small.empty() && !large.empty()) {
+            uint32_t s = small.back();
+            small.pop_back();
+            uint32_t l = large.back();
+            aliasProbability[s] = scaled[s];
+            alias[s] = l;
+            scaled[l] -= 1.0 - scaled[s];
+            if(scaled[l] < 1.0) {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+        // Leftovers are 1 up to rounding and keep their own bucket
+    }
+
+public:
+    StakeIndex() : total(0), frozen(false) {}
+
+    // Returns the index of the new validator
+    size_t add(uint64_t stake) {
+        stakes.push_back(stake);
+        size_t i = stakes.size();
+        if(tree.empty()) {
+            tree.push_back(0);
+        }
+        uint64_t node = stake;
+        for(size_t k = i - 1; k > i - lowbit(i); k -= lowbit(k)) {
+            node += tree[k];
+        }
+        tree.push_back(node);
+        total += stake;
+        frozen = false;
+        return i - 1;
+    }
+
+    void setStake(size_t index, uint64_t stake) {
+        // Unsigned wrap-around makes the same delta work up and down
+        uint64_t delta = stake - stakes[index];
+        stakes[index] = stake;
+        for(size_t k = index + 1; k < tree.size(); k += lowbit(k)) {
+            tree[k] += delta;
+        }
+        total += delta;
+        frozen = false;
+    }
+
+    // Sum of the stakes of validators 0..index-1
+    uint64_t prefixStake(size_t index) const {
+        uint64_t sum = 0;
+        for(size_t k = index; k > 0; k -= lowbit(k)) {
+            sum += tree[k];
+        }
+        return sum;
+    }
+
+    // Validator owning ticket in [0, totalStake()): the first index whose
+    // cumulative stake exceeds it
+    size_t find(uint64_t ticket) const {
+        size_t step = 1;
+        while(step * 2 < tree.size()) {
+            step *= 2;
+        }
+        size_t pos = 0;
+        for(; step > 0; step >>= 1) {
+            if(pos + step < tree.size() && tree[pos + step] <= ticket) {
+                pos += step;
+                ticket -= tree[pos];
+            }
+        }
+        return pos;
+    }
+
+    // Stakes must not change until the next setStake or add
+    void freeze() {
+        if(!frozen && total > 0) {
+            buildAlias();
+            frozen = true;
+        }
+    }
+
+    // Returns size() if the total stake is 0
+    template <typename Rng>
+    size_t sample(Rng& rng) const {
+        if(total == 0) {
+            return stakes.size();
+        }
+        if(frozen) {
+            std::uniform_int_distribution<size_t> bucket(0, stakes.size() - 1);
+            std::uniform_real_distribution<double> coin(0.0, 1.0);
+            size_t i = bucket(rng);
+            return coin(rng) < aliasProbability[i] ? i : alias[i];
+        }
+        std::uniform_int_distribution<uint64_t> ticket(0, total - 1);
+        return find(ticket(rng));
+    }
+
+    uint64_t getStake(size_t index) const { return stakes[index]; }
+    uint64_t totalStake() const { return total; }
+    size_t size() const { return stakes.size(); }
+    bool isFrozen() const { return frozen; }
+};
+
+#endif //IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_STAKE_INDEX_H
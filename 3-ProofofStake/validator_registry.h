@@ -0,0 +1,254 @@
+//
+// Created by abdelaziz on 10/17/2026.
+//
+
+#ifndef IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_VALIDATOR_REGISTRY_H
+#define IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_VALIDATOR_REGISTRY_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <cstdint>
+#include "stake_index.h"
+#include "../0-Common/ed25519.h"
+
+struct ValidatorRecord {
+    std::string address;
+    uint64_t stake;         // bonded: the weight used for selection
+    uint64_t unbonding;     // leaving, not selectable but still slashable
+    uint64_t slashed;       // burnt so far
+    PublicKey publicKey;    // checks the signatures of its blocks; all zero if not registered
+
+    ValidatorRecord(const std::string& addr, uint64_t stakeAmount)
+            : address(addr), stake(stakeAmount), unbonding(0), slashed(0) {
+        publicKey.fill(0);
+    }
+
+    bool hasPublicKey() const { return publicKey != PublicKey(); }
+};
+
+struct Unbonding {
+    std::string address;
+    uint64_t amount;
+    uint64_t releaseEpoch;
+};
+
+// Validators as of one moment; copying it costs one shared_ptr
+class ValidatorSnapshot {
+public:
+    struct State {
+        std::vector<ValidatorRecord> validators;
+        std::unordered_map<std::string, size_t> byAddress;
+        StakeIndex stakes;      // stakes.getStake(i) == validators[i].stake
+
+        const ValidatorRecord* find(const std::string& address) const {
+            std::unordered_map<std::string, size_t>::const_iterator it = byAddress.find(address);
+            return it == byAddress.end() ? nullptr : &validators[it->second];
+        }
+    };
+
+private:
+    std::shared_ptr<const State> state;
+
+public:
+    explicit ValidatorSnapshot(const std::shared_ptr<const State>& shared) : state(shared) {}
+
+    // nullptr if the address never bonded
+    const ValidatorRecord* find(const std::string& address) const { return state->find(address); }
+
+    uint64_t getStake(const std::string& address) const {
+        const ValidatorRecord* record = find(address);
+        return record ? record->stake : 0;
+    }
+
+    // Probability proportional to stake; "" if no stake at all
+    template <typename Rng>
+    std::string sample(Rng& rng) const {
+        size_t selected = state->stakes.sample(rng);
+        return selected < state->validators.size() ? state->validators[selected].address : "";
+    }
+
+    const std::vector<ValidatorRecord>& getValidators() const { return state->validators; }
+    const StakeIndex& getStakeIndex() const { return state->stakes; }
+    uint64_t totalStake() const { return state->stakes.totalStake(); }
+    size_t size() const { return state->validators.size(); }
+};
+
+// Validators by address with their bonded stake, kept in sync with a
+// StakeIndex for selection. Stake leaves through an unbonding queue, during
+// which it can still be slashed.
+//
+// The state is copy-on-write: snapshot() shares it in O(1) and the first
+// change after a snapshot copies it once, so taking one at every epoch
+// boundary costs one copy per epoch with changes, none otherwise.
+class ValidatorRegistry {
+private:
+    typedef ValidatorSnapshot::State State;
+
+    std::shared_ptr<State> state;
+    std::multimap<uint64_t, Unbonding> unbondingQueue;     // by release epoch
+
+    State& mutableState() {
+        if(state.use_count() > 1) {
+            state = std::make_shared<State>(*state);
+        }
+        return *state;
+    }
+
+    // basisPoints / 10000 of amount, rounded down, without overflow
+    static uint64_t fraction(uint64_t amount, uint32_t basisPoints) {
+        return amount / 10000 * basisPoints + amount % 10000 * basisPoints / 10000;
+    }
+
+public:
+    ValidatorRegistry() : state(std::make_shared<State>()) {}
+
+    // Adds the validator or increases its stake
+    void bond(const std::string& address, uint64_t amount) {
+        State& s = mutableState();
+        std::unordered_map<std::string, size_t>::iterator it = s.byAddress.find(address);
+        if(it == s.byAddress.end()) {
+            s.byAddress[address] = s.validators.size();
+            s.validators.push_back(ValidatorRecord(address, amount));
+            s.stakes.add(amount);
+            return;
+        }
+        ValidatorRecord& record = s.validators[it->second];
+        record.stake += amount;
+        s.stakes.setStake(it->second, record.stake);
+    }
+
+    // Returns false if the validator never bonded
+    bool setPublicKey(const std::string& address, const PublicKey& key) {
+        if(state->find(address) == nullptr) {
+            return false;
+        }
+        State& s = mutableState();
+        s.validators[s.byAddress[address]].publicKey = key;
+        return true;
+    }
+
+    // Removes amount from the selectable stake at once; it is returned by
+    // releaseUnbonded(releaseEpoch). Returns false if the validator does
+    // not have that much bonded.
+    bool unbond(const std::string& address, uint64_t amount, uint64_t releaseEpoch) {
+        const ValidatorRecord* found = state->find(address);
+        if(found == nullptr || found->stake < amount) {
+            return false;
+        }
+        State& s = mutableState();
+        size_t index = s.byAddress[address];
+        ValidatorRecord& record = s.validators[index];
+        record.stake -= amount;
+        record.unbonding += amount;
+        s.stakes.setStake(index, record.stake);
+
+        Unbonding entry;
+        entry.address = address;
+        entry.amount = amount;
+        entry.releaseEpoch = releaseEpoch;
+        unbondingQueue.insert(std::make_pair(releaseEpoch, entry));
+        return true;
+    }
+
+    // Unbondings due at or before epoch, what is left of them after slashing
+    std::vector<Unbonding> releaseUnbonded(uint64_t epoch) {
+        std::vector<Unbonding> released;
+        std::multimap<uint64_t, Unbonding>::iterator end = unbondingQueue.upper_bound(epoch);
+        if(unbondingQueue.begin() == end) {
+            return released;
+        }
+        State& s = mutableState();
+        for(std::multimap<uint64_t, Unbonding>::iterator it = unbondingQueue.begin(); it != end; ++it) {
+            s.validators[s.byAddress[it->second.address]].unbonding -= it->second.amount;
+            released.push_back(it->second);
+        }
+        unbondingQueue.erase(unbondingQueue.begin(), end);
+        return released;
+    }
+
+    // Burns basisPoints / 10000 of the validator's bonded and unbonding
+    // stake; returns the amount burnt
+    uint64_t slash(const std::string& address, uint32_t basisPoints) {
+        if(state->find(address) == nullptr || basisPoints == 0) {
+            return 0;
+        }
+        if(basisPoints > 10000) {
+            basisPoints = 10000;
+        }
+        State& s = mutableState();
+        size_t index = s.byAddress[address];
+        ValidatorRecord& record = s.validators[index];
+
+        uint64_t burnt = fraction(record.stake, basisPoints);
+        record.stake -= burnt;
+        s.stakes.setStake(index, record.stake);
+        for(auto& pending : unbondingQueue) {
+            if(pending.second.address == address) {
+                uint64_t cut = fraction(pending.second.amount, basisPoints);
+                pending.second.amount -= cut;
+                record.unbonding -= cut;
+                burnt += cut;
+            }
+        }
+        record.slashed += burnt;
+        return burnt;
+    }
+
+    // O(1) sampling until the next change (see StakeIndex::freeze)
+    void freeze() {
+        if(!state->stakes.isFrozen()) {
+            mutableState().stakes.freeze();
+        }
+    }
+
+    // Replaces every validator and pending unbonding, e.g. with those of a
+    // saved state; records must have distinct addresses
+    void restore(const std::vector<ValidatorRecord>& records, const std::vector<Unbonding>& pending) {
+        std::shared_ptr<State> restored = std::make_shared<State>();
+        for(const auto& record : records) {
+            restored->byAddress[record.address] = restored->validators.size();
+            restored->validators.push_back(record);
+            restored->stakes.add(record.stake);
+        }
+        state = restored;
+        unbondingQueue.clear();
+        for(const auto& entry : pending) {
+            unbondingQueue.insert(std::make_pair(entry.releaseEpoch, entry));
+        }
+    }
+
+    ValidatorSnapshot snapshot() const { return ValidatorSnapshot(state); }
+
+    const ValidatorRecord* find(const std::string& address) const { return state->find(address); }
+
+    uint64_t getStake(const std::string& address) const {
+        const ValidatorRecord* record = find(address);
+        return record ? record->stake : 0;
+    }
+
+    template <typename Rng>
+    std::string sample(Rng& rng) const {
+        size_t selected = state->stakes.sample(rng);
+        return selected < state->validators.size() ? state->validators[selected].address : "";
+    }
+
+    const std::vector<ValidatorRecord>& getValidators() const { return state->validators; }
+    const ValidatorRecord& getValidator(size_t index) const { return state->validators[index]; }
+    uint64_t totalStake() const { return state->stakes.totalStake(); }
+    size_t size() const { return state->validators.size(); }
+    size_t pendingUnbondings() const { return unbondingQueue.size(); }
+
+    // By release epoch
+    std::vector<Unbonding> getUnbondings() const {
+        std::vector<Unbonding> pending;
+        for(const auto& entry : unbondingQueue) {
+            pending.push_back(entry.second);
+        }
+        return pending;
+    }
+};
+
+#endif //IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_VALIDATOR_REGISTRY_H
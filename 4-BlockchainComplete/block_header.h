@@ -0,0 +1,139 @@
+//
+// Created by abdelaziz on 10/17/2026.
+//
+
+#ifndef IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_BLOCK_HEADER_H
+#define IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_BLOCK_HEADER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include "../0-Common/digest.h"
+
+// Preimage formats of BlockComplete::calculateBlockHash
+enum BlockVersion {
+    BLOCK_VERSION_TEXT = 1,         // index timestamp previousHash ... streamed as text, no delimiters
+    BLOCK_VERSION_BINARY = 2,       // BlockHeader with a 32-bit nonce
+    BLOCK_VERSION_WIDE_NONCE = 3    // BlockHeader with a 64-bit nonce and an extra nonce
+};
+
+// Canonical binary block header, integers big-endian:
+//
+//   offset  version 2 (180 bytes)      version 3 (176 bytes)
+//   0       version        4           version        4
+//   4       index          4           index          4
+//   8       timestamp      8           timestamp      8
+//   16      previousHash   32          previousHash   32
+//   48      merkleRoot     32          merkleRoot     32
+//   80      stateRoot      32          stateRoot      32
+//   112     target         32          target         32
+//   144     validatorId    32          validatorId    20
+//   164                                extraNonce     4
+//   168/176 nonce          4           nonce          8
+//
+// stateRoot is zero when the block has none, validatorId is SHA256 of the
+// validator address (its first 20 bytes in version 3) and zero for PoW
+// blocks. Every field has a fixed place, so two different headers never
+// encode to the same bytes. The nonces come after byte 128 and the header
+// ends before byte 184, so each candidate costs a single compression after
+// the midstate, extra nonce rollovers included.
+struct BlockHeader {
+    static const size_t MAX_SIZE = 180;
+
+    uint32_t version;
+    uint32_t index;
+    int64_t timestamp;
+    Digest previousHash;
+    Digest merkleRoot;
+    Digest stateRoot;
+    Digest target;
+    Digest validatorId;
+    uint32_t extraNonce;    // version 3 only
+    uint64_t nonce;         // 32 bits in version 2
+
+    BlockHeader() : version(BLOCK_VERSION_WIDE_NONCE), index(0), timestamp(0), extraNonce(0), nonce(0) {
+        previousHash.fill(0);
+        merkleRoot.fill(0);
+        stateRoot.fill(0);
+        target.fill(0);
+        validatorId.fill(0);
+    }
+
+    static bool isWide(uint32_t version) { return version == BLOCK_VERSION_WIDE_NONCE; }
+    static size_t sizeOf(uint32_t version) { return isWide(version) ? 176 : 180; }
+    static size_t nonceOffsetOf(uint32_t version) { return isWide(version) ? 168 : 176; }
+    static size_t nonceBytesOf(uint32_t version) { return isWide(version) ? 8 : 4; }
+    static uint64_t maxNonceOf(uint32_t version) { return isWide(version) ? UINT64_MAX : UINT32_MAX; }
+
+    size_t size() const { return sizeOf(version); }
+    size_t nonceOffset() const { return nonceOffsetOf(version); }
+
+    static void writeUint(uint8_t* p, uint64_t v, size_t bytes) {
+        for(size_t i = bytes; i > 0; i--, v >>= 8) {
+            p[i - 1] = (uint8_t)v;
+        }
+    }
+
+    static uint64_t readUint(const uint8_t* p, size_t bytes) {
+        uint64_t v = 0;
+        for(size_t i = 0; i < bytes; i++) {
+            v = (v << 8) | p[i];
+        }
+        return v;
+    }
+
+    // out must hold size() bytes
+    void encode(uint8_t* out) const {
+        writeUint(out, version, 4);
+        writeUint(out + 4, index, 4);
+        writeUint(out + 8, (uint64_t)timestamp, 8);
+        std::memcpy(out + 16, previousHash.data(), 32);
+        std::memcpy(out + 48, merkleRoot.data(), 32);
+        std::memcpy(out + 80, stateRoot.data(), 32);
+        std::memcpy(out + 112, target.data(), 32);
+        if(isWide(version)) {
+            std::memcpy(out + 144, validatorId.data(), 20);
+            writeUint(out + 164, extraNonce, 4);
+            writeUint(out + 168, nonce, 8);
+        } else {
+            std::memcpy(out + 144, validatorId.data(), 32);
+            writeUint(out + 176, nonce, 4);
+        }
+    }
+
+    // Returns false if the version is not a binary one or size does not match it
+    static bool decode(const uint8_t* in, size_t size, BlockHeader& out) {
+        if(size < 4) {
+            return false;
+        }
+        uint32_t version = (uint32_t)readUint(in, 4);
+        if((version != BLOCK_VERSION_BINARY && version != BLOCK_VERSION_WIDE_NONCE) || size != sizeOf(version)) {
+            return false;
+        }
+        out = BlockHeader();
+        out.version = version;
+        out.index = (uint32_t)readUint(in + 4, 4);
+        out.timestamp = (int64_t)readUint(in + 8, 8);
+        std::memcpy(out.previousHash.data(), in + 16, 32);
+        std::memcpy(out.merkleRoot.data(), in + 48, 32);
+        std::memcpy(out.stateRoot.data(), in + 80, 32);
+        std::memcpy(out.target.data(), in + 112, 32);
+        if(isWide(version)) {
+            std::memcpy(out.validatorId.data(), in + 144, 20);
+            out.extraNonce = (uint32_t)readUint(in + 164, 4);
+            out.nonce = readUint(in + 168, 8);
+        } else {
+            std::memcpy(out.validatorId.data(), in + 144, 32);
+            out.nonce = readUint(in + 176, 4);
+        }
+        return true;
+    }
+
+    Digest hash() const {
+        uint8_t bytes[MAX_SIZE];
+        encode(bytes);
+        return sha256Digest(bytes, size());
+    }
+};
+
+#endif //IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_BLOCK_HEADER_H
@@ -0,0 +1,295 @@
+//
+// Created by abdelaziz on 10/17/2026.
+//
+
+#ifndef IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_BLOCK_STORE_H
+#define IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_BLOCK_STORE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <fstream>
+#include <cstdio>
+#include <cstdint>
+#include "../0-Common/digest.h"
+#include "../0-Common/mapped_file.h"
+#include "block_header.h"
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <direct.h>
+#endif
+
+// Append-only store of encoded blocks, one record per height, in segment
+// files directory/blocks_00000.dat, blocks_00001.dat, ... A new segment is
+// started when the current one would grow past segmentBytes.
+//
+// Record, integers big-endian:
+//
+//   length    4   size of what follows the checksum
+//   checksum  8   first 8 bytes of SHA256(height || hash || SHA256(payload))
+//   height    8
+//   hash      32  block hash
+//   payload   length - 40
+//
+// open() rebuilds the height and hash indexes by walking the records.
+// A crash can only leave a partial record at the end of the last segment;
+// its records are checked against their checksum and the file is cut
+// after the last good one. Earlier segments were synced when they were
+// closed and are trusted.
+//
+// Reads go through mmap: readRecord returns a pointer into the mapped
+// segment, valid until the next readRecord (which remaps the last segment
+// once it has grown). Not thread-safe.
+class BlockStore {
+private:
+    struct Location {
+        uint32_t segment;
+        uint64_t offset;    // of the payload
+        uint32_t length;    // of the payload
+    };
+
+    static const size_t RECORD_HEADER = 4 + 8;
+    static const size_t RECORD_KEY = 8 + 32;
+
+    std::string directory;
+    size_t segmentBytes;
+    std::vector<Location> byHeight;
+    std::unordered_map<Digest, uint64_t, DigestHasher> byHash;
+    std::vector<std::unique_ptr<MappedFile> > segments;
+    uint64_t activeSize;                // bytes in the last segment
+    std::FILE* writer;
+    uint64_t recoveredBytes;
+    bool healthy;
+
+    static bool fileExists(const std::string& path) {
+        std::ifstream in(path.c_str(), std::ios::binary);
+        return in.good();
+    }
+
+    static uint64_t checksum(const uint8_t* key, const uint8_t* payload, size_t length) {
+        uint8_t input[RECORD_KEY + SHA256_DIGEST_LENGTH];
+        std::memcpy(input, key, RECORD_KEY);
+        Digest payloadDigest = sha256Digest(payload, length);
+        std::memcpy(input + RECORD_KEY, payloadDigest.data(), payloadDigest.size());
+        return BlockHeader::readUint(sha256Digest(input, sizeof(input)).data(), 8);
+    }
+
+    // Keeps the first length bytes of the file; the prefix is written
+    // aside then renamed over it, so a crash here loses nothing
+    bool cutFile(const std::string& path, const uint8_t* data, size_t length) {
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream out(temporary.c_str(), std::ios::binary | std::ios::trunc);
+            out.write((const char*)data, (std::streamsize)length);
+            if(!out) {
+                return false;
+            }
+        }
+#ifdef _WIN32
+        std::remove(path.c_str());
+#endif
+        return std::rename(temporary.c_str(), path.c_str()) == 0;
+    }
+
+    // Indexes the records of one segment; returns the offset after the last good one
+    size_t scanSegment(uint32_t segment, const MappedFile& file, bool verify) {
+        const uint8_t* data = file.data();
+        size_t offset = 0;
+        while(file.size() - offset >= RECORD_HEADER + RECORD_KEY) {
+            uint32_t length = (uint32_t)BlockHeader::readUint(data + offset, 4);
+            if(length < RECORD_KEY || file.size() - offset - RECORD_HEADER < length) {
+                break;
+            }
+            const uint8_t* key = data + offset + RECORD_HEADER;
+            const uint8_t* payload = key + RECORD_KEY;
+            if(BlockHeader::readUint(key, 8) != byHeight.size()
+               || (verify && checksum(key, payload, length - RECORD_KEY) != BlockHeader::readUint(data + offset + 4, 8))) {
+                break;
+            }
+            Location location;
+            location.segment = segment;
+            location.offset = offset + RECORD_HEADER + RECORD_KEY;
+            location.length = length - (uint32_t)RECORD_KEY;
+            Digest hash;
+            std::memcpy(hash.data(), key + 8, hash.size());
+            byHash[hash] = byHeight.size();
+            byHeight.push_back(location);
+            offset += RECORD_HEADER + length;
+        }
+        return offset;
+    }
+
+    bool openWriter() {
+        writer = std::fopen(segmentPath(segments.size() - 1).c_str(), "ab");
+        return writer != nullptr;
+    }
+
+    void closeWriter() {
+        if(writer != nullptr) {
+            std::fflush(writer);
+#ifndef _WIN32
+            fsync(fileno(writer));
+#endif
+            std::fclose(writer);
+            writer = nullptr;
+        }
+    }
+
+public:
+    explicit BlockStore(const std::string& dir, size_t maxSegmentBytes = 64 << 20)
+            : directory(dir), segmentBytes(maxSegmentBytes), activeSize(0), writer(nullptr),
+              recoveredBytes(0), healthy(false) {}
+
+    ~BlockStore() {
+        closeWriter();
+    }
+
+    BlockStore(const BlockStore&) = delete;
+    BlockStore& operator=(const BlockStore&) = delete;
+
+    // Creates the directory if needed, indexes the stored records and
+    // drops a torn tail. Returns false if the directory is unusable or a
+    // segment before the last is damaged.
+    bool open() {
+        closeWriter();
+        byHeight.clear();
+        byHash.clear();
+        segments.clear();
+        recoveredBytes = 0;
+#ifndef _WIN32
+        mkdir(directory.c_str(), 0755);
+#else
+        _mkdir(directory.c_str());
+#endif
+        for(uint32_t segment = 0; fileExists(segmentPath(segment)); segment++) {
+            std::unique_ptr<MappedFile> file(new MappedFile());
+            if(!file->open(segmentPath(segment))) {
+                return healthy = false;
+            }
+            bool last = !fileExists(segmentPath(segment + 1));
+            size_t good = scanSegment(segment, *file, last);
+            if(good < file->size()) {
+                if(!last) {
+                    return healthy = false;
+                }
+                recoveredBytes = file->size() - good;
+                std::vector<uint8_t> prefix(file->data(), file->data() + good);
+                file->close();
+                if(!cutFile(segmentPath(segment), prefix.data(), prefix.size()) || !file->open(segmentPath(segment))) {
+                    return healthy = false;
+                }
+            }
+            activeSize = file->size();
+            segments.push_back(std::move(file));
+        }
+        if(segments.empty()) {
+            segments.push_back(std::unique_ptr<MappedFile>(new MappedFile()));
+            activeSize = 0;
+        }
+        return healthy = openWriter();
+    }
+
+    // height must be size(). Returns false, and the store stops accepting
+    // blocks, on a write error.
+    bool append(uint64_t height, const Digest& hash, const std::vector<uint8_t>& payload) {
+        if(!healthy || height != byHeight.size()) {
+            return false;
+        }
+        size_t recordSize = RECORD_HEADER + RECORD_KEY + payload.size();
+        if(activeSize > 0 && activeSize + recordSize > segmentBytes) {
+            closeWriter();
+            segments.push_back(std::unique_ptr<MappedFile>(new MappedFile()));
+            activeSize = 0;
+            if(!openWriter()) {
+                return healthy = false;
+            }
+        }
+
+        std::vector<uint8_t> record(RECORD_HEADER + RECORD_KEY);
+        BlockHeader::writeUint(record.data(), RECORD_KEY + payload.size(), 4);
+        uint8_t* key = record.data() + RECORD_HEADER;
+        BlockHeader::writeUint(key, height, 8);
+        std::memcpy(key + 8, hash.data(), hash.size());
+        BlockHeader::writeUint(record.data() + 4, checksum(key, payload.data(), payload.size()), 8);
+        if(std::fwrite(record.data(), 1, record.size(), writer) != record.size()
+           || std::fwrite(payload.data(), 1, payload.size(), writer) != payload.size()
+           || std::fflush(writer) != 0) {
+            return healthy = false;
+        }
+
+        Location location;
+        location.segment = (uint32_t)(segments.size() - 1);
+        location.offset = activeSize + RECORD_HEADER + RECORD_KEY;
+        location.length = (uint32_t)payload.size();
+        byHash[hash] = byHeight.size();
+        byHeight.push_back(location);
+        activeSize += recordSize;
+        return true;
+    }
+
+    // Forces the appended records to disk
+    void sync() {
+        if(writer != nullptr) {
+            std::fflush(writer);
+#ifndef _WIN32
+            fsync(fileno(writer));
+#endif
+        }
+    }
+
+    // Payload of the block at height, in place in the mapped segment
+    bool readRecord(uint64_t height, const uint8_t*& data, size_t& length) {
+        if(height >= byHeight.size()) {
+            return false;
+        }
+        const Location& location = byHeight[height];
+        MappedFile& file = *segments[location.segment];
+        if(file.size() < location.offset + location.length && !file.open(segmentPath(location.segment))) {
+            return false;
+        }
+        data = file.data() + location.offset;
+        length = location.length;
+        return true;
+    }
+
+    bool findHeight(const Digest& hash, uint64_t& height) const {
+        std::unordered_map<Digest, uint64_t, DigestHasher>::const_iterator it = byHash.find(hash);
+        if(it == byHash.end()) {
+            return false;
+        }
+        height = it->second;
+        return true;
+    }
+
+    std::string segmentPath(size_t segment) const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "/blocks_%05u.dat", (unsigned)segment);
+        return directory + name;
+    }
+
+    uint64_t size() const { return byHeight.size(); }
+    size_t getSegmentCount() const { return segments.size(); }
+    // Bytes of torn records dropped by the last open()
+    uint64_t getRecoveredBytes() const { return recoveredBytes; }
+    bool good() const { return healthy; }
+    const std::string& getDirectory() const { return directory; }
+
+    // Deletes the segments of a store that is not open
+    static void removeAll(const std::string& dir) {
+        BlockStore store(dir);
+        for(uint32_t segment = 0; fileExists(store.segmentPath(segment)); segment++) {
+            std::remove(store.segmentPath(segment).c_str());
+        }
+#ifndef _WIN32
+        rmdir(dir.c_str());
+#else
+        _rmdir(dir.c_str());
+#endif
+    }
+};
+
+#endif //IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_BLOCK_STORE_H
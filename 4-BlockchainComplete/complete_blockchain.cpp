@@ -3,8 +3,12 @@
 //
 
 #include "complete_blockchain.h"
+#include "mining_service.h"
 #include <iostream>
+#include <fstream>
 #include <chrono>
+#include <algorithm>
+#include <cctype>
 
 void printSeparator() {
     std::cout << "========================================" << std::endl;
@@ -157,6 +161,492 @@ int main() {
     std::cout << "  Validateurs enregistres: " << blockchain.getValidators().size() << std::endl;
     std::cout << "  Integrite de la chaine: " << (blockchain.isChainValid() ? "VALIDE" : "INVALIDE") << std::endl;
 
+    std::cout << std::endl << "PARTIE 5: Preuves d'inclusion Merkle" << std::endl;
+    printSeparator();
+
+    CompleteBlockchain proofChain;
+    std::vector<Transaction> blockTxs;
+    for(int i = 0; i < 11; i++) {
+        std::stringstream ss;
+        ss << "TX_Proof_" << i;
+        blockTxs.push_back(Transaction(ss.str(), "Payer", "Payee", 1.0 + i));
+    }
+    proofChain.addBlockPoW(blockTxs, 2);
+    std::string blockRoot = proofChain.getBlock(1).getMerkleRoot();
+
+    MerkleProof proof = proofChain.getTransactionProof(1, 10);
+    std::cout << "Taille de la preuve pour TX 10: " << proof.siblings.size() << " hashes" << std::endl;
+    std::cout << "Preuve TX 10 valide: "
+              << (MerkleTreeComplete::verifyTransaction(blockTxs[10], proof, blockRoot) ? "OUI" : "NON") << std::endl;
+    std::cout << "Preuve rejetee pour une autre transaction: "
+              << (!MerkleTreeComplete::verifyTransaction(blockTxs[3], proof, blockRoot) ? "OUI" : "NON") << std::endl;
+
+    std::vector<MerkleProof> proofs;
+    for(size_t i = 0; i < blockTxs.size(); i++) {
+        proofs.push_back(proofChain.getTransactionProof(1, i));
+    }
+    std::vector<bool> results;
+    std::cout << "Verification groupee de " << proofs.size() << " preuves: "
+              << (MerkleTreeComplete::verifyTransactions(blockTxs, proofs, blockRoot, results) ? "OUI" : "NON")
+              << std::endl;
+
+    std::vector<size_t> subset = {2, 3, 7, 10};
+    MerkleMultiProof multiProof = proofChain.getTransactionMultiProof(1, subset);
+    std::vector<Transaction> subsetTxs;
+    for(size_t i : subset) {
+        subsetTxs.push_back(blockTxs[i]);
+    }
+    std::cout << "Multi-preuve pour 4 transactions: " << multiProof.hashes.size() << " hashes, valide: "
+              << (MerkleTreeComplete::verifyMultiProof(subsetTxs, multiProof, blockRoot) ? "OUI" : "NON") << std::endl;
+
+    std::cout << std::endl << "PARTIE 6: Etat des comptes (Sparse Merkle Tree)" << std::endl;
+    printSeparator();
+
+    CompleteBlockchain stateChain;
+    std::vector<Transaction> payments;
+    payments.push_back(Transaction("TX_S1", "Alice", "Bob", 30.0));
+    payments.push_back(Transaction("TX_S2", "Bob", "Charlie", 12.5));
+    stateChain.addBlockPoW(payments, 2);
+
+    std::vector<Transaction> morePayments;
+    morePayments.push_back(Transaction("TX_S3", "Charlie", "Alice", 2.5));
+    stateChain.addBlockPoW(morePayments, 2);
+
+    std::cout << "Solde Alice: " << stateChain.getBalance("Alice") << std::endl;
+    std::cout << "Solde Bob: " << stateChain.getBalance("Bob") << std::endl;
+    std::cout << "Solde Charlie: " << stateChain.getBalance("Charlie") << std::endl;
+
+    Digest stateRoot;
+    hexToDigest(stateChain.getLastBlock().getStateRoot(), stateRoot);
+    SparseMerkleTree::Proof bobProof = stateChain.getBalanceProof("Bob");
+    std::cout << "Preuve du solde de Bob valide: "
+              << (SparseMerkleTree::verifyBalance(stateRoot, "Bob", 17.5, bobProof) ? "OUI" : "NON") << std::endl;
+    SparseMerkleTree::Proof daveProof = stateChain.getBalanceProof("Dave");
+    std::cout << "Preuve d'absence de Dave valide: "
+              << (SparseMerkleTree::verifyAbsent(stateRoot, "Dave", daveProof) ? "OUI" : "NON") << std::endl;
+    std::cout << "Etat rejoue coherent avec les blocs: " << (stateChain.isStateValid() ? "OUI" : "NON") << std::endl;
+    std::cout << "Chaine valide: " << (stateChain.isChainValid() ? "OUI" : "NON") << std::endl;
+
+    // The binary header keeps the root's bytes: an uppercase copy hashes the same
+    BlockComplete recased = stateChain.getLastBlock();
+    std::string upperRoot = recased.getStateRoot();
+    std::transform(upperRoot.begin(), upperRoot.end(), upperRoot.begin(), ::toupper);
+    recased.setStateRoot(upperRoot);
+    std::cout << "Racine d'etat non canonique refusee: "
+              << (recased.calculateBlockHash() == recased.getHash() && !recased.hasCanonicalFields()
+                  && stateChain.getLastBlock().hasCanonicalFields() ? "OUI" : "NON") << std::endl;
+
+    SparseMerkleTree accounts;
+    std::vector<std::pair<std::string, double> > batch;
+    for(int i = 0; i < 20000; i++) {
+        std::stringstream ss;
+        ss << "Account_" << i;
+        batch.push_back(std::make_pair(ss.str(), 1.0 + i));
+    }
+    auto startState = std::chrono::high_resolution_clock::now();
+    accounts.applyBatch(batch);
+    auto endState = std::chrono::high_resolution_clock::now();
+    std::cout << "20000 comptes inseres en un lot: "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(endState - startState).count()
+              << " ms" << std::endl;
+
+    std::stringstream stored;
+    accounts.save(stored);
+    size_t firstSave = stored.str().size();
+    accounts.setBalance("Account_42", 0);
+    accounts.setBalance("Account_43", 7.0);
+    accounts.save(stored);
+    std::cout << "Taille sauvegarde initiale: " << firstSave << " octets, increment: "
+              << stored.str().size() - firstSave << " octets" << std::endl;
+
+    SparseMerkleTree reloaded;
+    bool loaded = reloaded.load(stored);
+    std::cout << "Arbre recharge identique: "
+              << (loaded && reloaded.getRoot() == accounts.getRoot() && reloaded.getAccountCount() == 19999 ? "OUI" : "NON")
+              << std::endl;
+
+    std::cout << std::endl << "PARTIE 7: En-tete binaire de taille fixe" << std::endl;
+    printSeparator();
+
+    CompleteBlockchain versioned;
+    versioned.setBlockVersion(BLOCK_VERSION_TEXT);
+    versioned.addBlockPoW(transactions1, 3);
+    versioned.setBlockVersion(BLOCK_VERSION_BINARY);
+    versioned.addBlockPoW(transactions1, 3);
+    versioned.setBlockVersion(BLOCK_VERSION_WIDE_NONCE);
+    versioned.addBlockPoW(transactions1, 3);
+    versioned.addBlockPoS(transactions1);
+
+    const BlockComplete& binaryBlock = versioned.getBlock(3);
+    const BlockHeader& header = versioned.getHeader(3);
+    uint8_t encoded[BlockHeader::MAX_SIZE];
+    header.encode(encoded);
+    BlockHeader decoded;
+    bool decodedOk = BlockHeader::decode(encoded, header.size(), decoded);
+    uint8_t reencoded[BlockHeader::MAX_SIZE];
+    decoded.encode(reencoded);
+
+    std::cout << "Versions des blocs 1 a 3: " << versioned.getBlock(1).getVersion() << ", "
+              << versioned.getBlock(2).getVersion() << ", " << binaryBlock.getVersion() << std::endl;
+    std::cout << "Taille des en-tetes v2 et v3: " << BlockHeader::sizeOf(BLOCK_VERSION_BINARY) << " et "
+              << header.size() << " octets, nonce: " << decoded.nonce << std::endl;
+    std::cout << "Decodage puis re-encodage identique: "
+              << (decodedOk && std::memcmp(encoded, reencoded, header.size()) == 0 ? "OUI" : "NON") << std::endl;
+    std::cout << "Hash = SHA256(en-tete): "
+              << (binaryBlock.getHash() == digestToHex(sha256Digest(encoded, header.size())) ? "OUI" : "NON") << std::endl;
+    bool headersMatch = versioned.getHeaders().size() == versioned.getSize();
+    for(size_t i = 1; i < versioned.getSize(); i++) {
+        headersMatch = headersMatch && digestToHex(versioned.getHeader(i).previousHash) == versioned.getBlock(i - 1).getHash();
+    }
+    std::cout << "En-tetes indexes chaines sans copier les blocs: " << (headersMatch ? "OUI" : "NON") << std::endl;
+    std::cout << "Chaine mixte texte/binaire/nonce 64 bits valide: " << (versioned.isChainValid() ? "OUI" : "NON") << std::endl;
+
+    BlockComplete serialBinary(5, binaryBlock.getHash(), transactions1);
+    BlockComplete parallelBinary = serialBinary;
+    serialBinary.mineBlock(4);
+    ParallelMiner headerMiner(4);
+    parallelBinary.mineBlockParallel(4, headerMiner);
+    std::cout << "Minage parallele de l'en-tete = sequentiel: "
+              << (parallelBinary.getNonce() == serialBinary.getNonce() && parallelBinary.getHash() == serialBinary.getHash()
+                  && serialBinary.getHash() == serialBinary.calculateBlockHash() ? "OUI" : "NON") << std::endl;
+
+    // Nonce space cut to 0..999 so the extra nonce has to roll over
+    BlockComplete serialRollover(6, binaryBlock.getHash(), transactions1);
+    BlockComplete parallelRollover = serialRollover;
+    serialRollover.mineBlock(DifficultyTarget::fromHexZeros(4), 999);
+    MiningResult rolled = parallelRollover.mineBlockParallel(DifficultyTarget::fromHexZeros(4), headerMiner, nullptr, 999);
+    std::cout << "Extra nonce apres epuisement des nonces 0..999: " << serialRollover.getExtraNonce()
+              << " (nonce " << serialRollover.getNonce() << ")" << std::endl;
+    std::cout << "Meme paire (extra nonce, nonce) en parallele: "
+              << (rolled.found && parallelRollover.getExtraNonce() == serialRollover.getExtraNonce()
+                  && parallelRollover.getNonce() == serialRollover.getNonce()
+                  && serialRollover.getHash() == serialRollover.calculateBlockHash() && serialRollover.meetsTarget()
+                  ? "OUI" : "NON") << std::endl;
+
+    std::cout << std::endl << "PARTIE 8: Ajustement automatique de la difficulte" << std::endl;
+    printSeparator();
+
+    CompleteBlockchain retargeted;
+    RetargetParams params(1.0, 4, DifficultyTarget::fromHexZeros(3));
+    retargeted.enableRetargeting(params);
+    for(int i = 0; i < 6; i++) {
+        auto startBlock = std::chrono::high_resolution_clock::now();
+        retargeted.addBlockPoW(transactions1);
+        auto endBlock = std::chrono::high_resolution_clock::now();
+        BlockComplete mined = retargeted.getLastBlock();
+        std::cout << "Block #" << mined.getIndex() << ": " << std::fixed << std::setprecision(1)
+                  << mined.getTarget().getDifficultyBits() << " bits, "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(endBlock - startBlock).count() << " ms"
+                  << std::endl;
+    }
+    std::cout << "Cible suivante: " << retargeted.getNextTarget().getDifficultyBits() << " bits" << std::endl;
+    std::cout << "Cibles verifiees par la validation: " << (retargeted.isChainValid() ? "OUI" : "NON") << std::endl;
+
+    std::cout << std::endl << "PARTIE 9: Service de minage asynchrone" << std::endl;
+    printSeparator();
+
+    CompleteBlockchain node;
+    MiningService service(2);
+    node.setBlockVersion(BLOCK_VERSION_WIDE_NONCE);
+    service.notifyNewTip(node.getLastBlock().getHash());
+
+    bool callbackCalled = false;
+    std::future<MinedBlock> first = service.submit(node.createBlockTemplate(transactions1), DifficultyTarget::fromHexZeros(4),
+                                                   [&](const MinedBlock& mined) { callbackCalled = mined.solved; });
+    MinedBlock solved = first.get();
+    // The same solution with TX3 renamed: balances and state root unchanged
+    std::vector<uint8_t> tamperedBytes;
+    solved.block.encode(tamperedBytes);
+    const char renamed[] = "TX3";
+    std::vector<uint8_t>::iterator id = std::search(tamperedBytes.begin(), tamperedBytes.end(), renamed, renamed + 3);
+    id[2] = '9';
+    BlockComplete tampered;
+    bool tamperedRejected = BlockComplete::decode(tamperedBytes.data(), tamperedBytes.size(), tampered)
+                            && !node.addMinedBlock(tampered) && node.getSize() == 1;
+    std::cout << "Transactions changees apres minage refusees: " << (tamperedRejected ? "OUI" : "NON") << std::endl;
+    bool accepted = solved.solved && node.addMinedBlock(solved.block);
+    service.notifyNewTip(node.getLastBlock().getHash());
+    std::cout << "Bloc mine en arriere-plan accepte: " << (accepted && callbackCalled ? "OUI" : "NON")
+              << " (nonce " << solved.block.getNonce() << ")" << std::endl;
+
+    // Two templates far too hard to finish, then a competing block arrives
+    std::future<MinedBlock> hard = service.submit(node.createBlockTemplate(payments), DifficultyTarget::fromHexZeros(8));
+    std::future<MinedBlock> queued = service.submit(node.createBlockTemplate(transactions1), DifficultyTarget::fromHexZeros(8));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    node.addBlockPoW(payments, 3);
+    auto tipChanged = std::chrono::steady_clock::now();
+    service.notifyNewTip(node.getLastBlock().getHash());
+    MinedBlock abandoned = hard.get();
+    double cancelMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - tipChanged).count();
+    MinedBlock dropped = queued.get();
+    std::cout << "Travail perime abandonne en " << std::fixed << std::setprecision(2) << cancelMs << " ms: "
+              << (abandoned.stale && !abandoned.solved && dropped.stale ? "OUI" : "NON") << std::endl;
+    std::cout << "Bloc perime refuse par la chaine: " << (!node.addMinedBlock(abandoned.block) ? "OUI" : "NON") << std::endl;
+
+    MiningServiceStats stats = service.getStats();
+    std::cout << "Modeles soumis: " << stats.submitted << ", resolus: " << stats.solved
+              << ", abandonnes: " << stats.staleAbandoned << ", retires de la file: " << stats.staleDropped << std::endl;
+    std::cout << "Temps perdu sur des modeles perimes: " << std::setprecision(1) << 100 * stats.staleFraction()
+              << "% (" << stats.staleHashes << " hashes, " << std::setprecision(2) << stats.staleSeconds * 1000
+              << " ms, arret en " << stats.maxCancelMs << " ms au pire)" << std::endl;
+    std::cout << "Chaine valide: " << (node.isChainValid() && node.isStateValid() ? "OUI" : "NON") << std::endl;
+
+    std::cout << std::endl << "PARTIE 10: Validation parallele de la chaine" << std::endl;
+    printSeparator();
+
+    CompleteBlockchain longChain;
+    longChain.addValidator("Validator_A", 100);
+    const int LONG_BLOCKS = 2000;
+    for(int i = 1; i <= LONG_BLOCKS; i++) {
+        longChain.addBlockPoS(transactions1);
+    }
+    for(unsigned threads : {1u, 4u}) {
+        // A copy has not been validated yet
+        CompleteBlockchain fresh = longChain;
+        fresh.setValidationThreads(threads);
+        fresh.getVerifier().clearCache();
+        auto startValidate = std::chrono::steady_clock::now();
+        bool valid = fresh.isChainValid();
+        auto endValidate = std::chrono::steady_clock::now();
+        std::cout << LONG_BLOCKS << " blocs sur " << threads << " thread(s): " << (valid ? "OUI" : "NON") << ", "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(endValidate - startValidate).count() << " ms"
+                  << std::endl;
+    }
+
+    // A key registered after the fact: the blocks signed from then on no longer verify
+    longChain.getRegistry().setPublicKey("Validator_A", Ed25519Key::generate().publicKey());
+    for(int i = 0; i < 10; i++) {
+        longChain.addBlockPoS(transactions1);
+    }
+    longChain.setValidationThreads(1);
+    size_t serialInvalid = longChain.findInvalidBlock();
+    longChain.setValidationThreads(4);
+    size_t parallelInvalid = longChain.findInvalidBlock();
+    std::cout << "Premier bloc invalide: " << parallelInvalid << " (attendu " << LONG_BLOCKS + 1 << "), "
+              << "meme reponse en serie: " << (parallelInvalid == serialInvalid ? "OUI" : "NON") << std::endl;
+    std::cout << "Chaine refusee: " << (!longChain.isChainValid() ? "OUI" : "NON") << std::endl;
+
+    // Mined but naming a validator: still a PoS block, which needs its leader's signature
+    CompleteBlockchain minedClaim;
+    minedClaim.addValidator("Validator_A", 100);
+    BlockComplete claimed(1, minedClaim.getLastBlock().getHash(), std::vector<Transaction>());
+    claimed.setStateRoot(minedClaim.getStateRoot());
+    claimed.validateBlockPoS(minedClaim.electValidator(claimed.getPreviousHash(), 1));
+    claimed.mineBlock(DifficultyTarget::fromHexZeros(1));
+    std::cout << "Bloc mine au nom d'un validateur sans sa signature refuse: "
+              << (!minedClaim.addMinedBlock(claimed) && minedClaim.getSize() == 1 ? "OUI" : "NON") << std::endl;
+
+    std::cout << std::endl << "PARTIE 11: Validation incrementale et points de controle" << std::endl;
+    printSeparator();
+
+    CompleteBlockchain tailChain;
+    tailChain.addValidator("Validator_A", 100);
+    for(int i = 1; i <= 500; i++) {
+        tailChain.addBlockPoS(transactions1);
+    }
+    CompleteBlockchain checkpointed = tailChain;
+    auto startFull = std::chrono::steady_clock::now();
+    bool fullValid = tailChain.isChainValid();
+    auto endFull = std::chrono::steady_clock::now();
+    tailChain.addBlockPoS(transactions1);
+    auto startTail = std::chrono::steady_clock::now();
+    bool tailValid = tailChain.isChainValid();
+    auto endTail = std::chrono::steady_clock::now();
+    std::cout << "Validation complete: " << (fullValid ? "OUI" : "NON") << " en "
+              << std::chrono::duration_cast<std::chrono::microseconds>(endFull - startFull).count()
+              << " us, puis du nouveau bloc seul: " << (tailValid ? "OUI" : "NON") << " en "
+              << std::chrono::duration_cast<std::chrono::microseconds>(endTail - startTail).count() << " us"
+              << " (hauteur verifiee " << tailChain.getVerifiedHeight() << ")" << std::endl;
+
+    checkpointed.addCheckpoint(490, checkpointed.getBlock(490).getHash());
+    auto startCheckpoint = std::chrono::steady_clock::now();
+    bool checkpointValid = checkpointed.isChainValid();
+    auto endCheckpoint = std::chrono::steady_clock::now();
+    std::cout << "Validation apres le point de controle 490: " << (checkpointValid ? "OUI" : "NON") << " en "
+              << std::chrono::duration_cast<std::chrono::microseconds>(endCheckpoint - startCheckpoint).count()
+              << " us" << std::endl;
+    checkpointed.addCheckpoint(200, checkpointed.getBlock(201).getHash());
+    std::cout << "Point de controle contredit a la hauteur 200: "
+              << (checkpointed.findInvalidBlock() == 200 ? "OUI" : "NON") << std::endl;
+
+    std::cout << std::endl << "PARTIE 12: Stockage des blocs sur disque" << std::endl;
+    printSeparator();
+
+    const std::string storeDirectory = "complete_store_demo";
+    const int STORED_BLOCKS = 2000;
+    BlockStore::removeAll(storeDirectory);
+    Ed25519Key storedKey = Ed25519Key::fromSeed(sha256Digest(std::string("Validator_S")));
+    std::string storedTip;
+    std::string storedStateRoot;
+    {
+        CompleteBlockchain writerChain;
+        writerChain.addValidator("Validator_S", 100, storedKey);
+        std::shared_ptr<BlockStore> store = std::make_shared<BlockStore>(storeDirectory, 256 << 10);
+        bool attached = store->open() && writerChain.attachStore(store);
+        auto startWrite = std::chrono::steady_clock::now();
+        for(int i = 1; i <= STORED_BLOCKS; i++) {
+            writerChain.addBlockPoS(i % 2 ? transactions1 : payments);
+        }
+        store->sync();
+        double writeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startWrite).count();
+        storedTip = writerChain.getLastBlock().getHash();
+        storedStateRoot = writerChain.getStateRoot();
+        std::cout << "Blocs ecrits: " << (attached && store->good() ? "OUI" : "NON") << ", " << store->size()
+                  << " en " << store->getSegmentCount() << " segments, " << std::fixed << std::setprecision(0)
+                  << STORED_BLOCKS / writeSeconds << " blocs/s (signature et etat compris)" << std::endl;
+    }
+
+    std::shared_ptr<BlockStore> reopened = std::make_shared<BlockStore>(storeDirectory, 256 << 10);
+    auto startRead = std::chrono::steady_clock::now();
+    bool readOk = reopened->open();
+    size_t readBlocks = 0;
+    for(uint64_t height = 0; readOk && height < reopened->size(); height++) {
+        const uint8_t* data;
+        size_t length;
+        BlockComplete block;
+        readOk = reopened->readRecord(height, data, length) && BlockComplete::decode(data, length, block);
+        readBlocks++;
+    }
+    double readSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startRead).count();
+    std::cout << "Blocs relus par mmap: " << (readOk ? "OUI" : "NON") << ", " << readBlocks << " a "
+              << readBlocks / readSeconds << " blocs/s" << std::endl;
+
+    CompleteBlockchain readerChain;
+    readerChain.addValidator("Validator_S", 100, storedKey);
+    bool attachedReader = readerChain.attachStore(reopened);
+    std::cout << "Chaine rechargee identique: "
+              << (attachedReader && readerChain.getSize() == (size_t)STORED_BLOCKS + 1 && readerChain.getLastBlock().getHash() == storedTip
+                  && readerChain.getStateRoot() == storedStateRoot && readerChain.isChainValid() ? "OUI" : "NON") << std::endl;
+    uint64_t tipHeight = 0;
+    Digest tipDigest;
+    hexToDigest(storedTip, tipDigest);
+    std::cout << "Hauteur retrouvee par le hash: "
+              << (reopened->findHeight(tipDigest, tipHeight) && tipHeight == (uint64_t)STORED_BLOCKS ? "OUI" : "NON") << std::endl;
+
+    // A crash in the middle of a write leaves part of a record at the end
+    std::string lastSegment = reopened->segmentPath(reopened->getSegmentCount() - 1);
+    reopened.reset();
+    readerChain = CompleteBlockchain();
+    {
+        std::ofstream torn(lastSegment.c_str(), std::ios::binary | std::ios::app);
+        const char partial[] = "\x00\x00\x01\x00partial record";
+        torn.write(partial, sizeof(partial) - 1);
+    }
+    std::shared_ptr<BlockStore> recovered = std::make_shared<BlockStore>(storeDirectory, 256 << 10);
+    bool recoveredOk = recovered->open();
+    std::cout << "Fin tronquee apres un arret brutal: " << (recoveredOk && recovered->size() == (uint64_t)STORED_BLOCKS + 1 ? "OUI" : "NON")
+              << ", " << recovered->getRecoveredBytes() << " octets retires" << std::endl;
+    CompleteBlockchain resumed;
+    resumed.addValidator("Validator_S", 100, storedKey);
+    bool resumedOk = resumed.attachStore(recovered);
+    resumed.addBlockPoS(transactions1);
+    std::cout << "Ecriture reprise apres recuperation: "
+              << (resumedOk && recovered->size() == resumed.getSize() && resumed.isChainValid() ? "OUI" : "NON") << std::endl;
+    recovered.reset();
+    resumed = CompleteBlockchain();
+    BlockStore::removeAll(storeDirectory);
+
+    // A store that cannot be written stops the chain instead of leaving it
+    // ahead of the disk
+    CompleteBlockchain unwritable;
+    unwritable.addValidator("Validator_A", 100);
+    std::shared_ptr<BlockStore> missing = std::make_shared<BlockStore>("complete_store_absent/blocks");
+    bool missingOpened = missing->open();
+    bool missingAttached = unwritable.attachStore(missing);
+    bool refused = !unwritable.addBlockPoS(transactions1) && !unwritable.addBlockPoW(transactions1, 1);
+    std::cout << "Bloc refuse si le stockage echoue: "
+              << (!missingOpened && !missingAttached && refused && unwritable.getSize() == 1 && unwritable.getBalance("Bob") == 0 ? "OUI" : "NON")
+              << std::endl;
+
+    std::cout << std::endl << "PARTIE 13: Demarrage depuis un instantane de l'etat" << std::endl;
+    printSeparator();
+
+    const std::string snapshotDirectory = "complete_snapshot_demo";
+    const int SNAPSHOT_INTERVAL = 500;
+    const int TAIL_BLOCKS = 20;
+    StateSnapshot::remove(snapshotDirectory);
+    BlockStore::removeAll(snapshotDirectory);
+    std::string snapshotTip;
+    std::string snapshotStateRoot;
+    uint64_t snapshotStake = 0;
+    uint64_t snapshotHeight = 0;
+    {
+        CompleteBlockchain writerChain;
+        writerChain.addValidator("Validator_S", 100, storedKey);
+        writerChain.setSnapshotInterval(SNAPSHOT_INTERVAL);
+        std::shared_ptr<BlockStore> store = std::make_shared<BlockStore>(snapshotDirectory, 256 << 10);
+        bool attached = store->open() && writerChain.attachStore(store);
+        for(int i = 1; i < STORED_BLOCKS + TAIL_BLOCKS; i++) {
+            writerChain.addBlockPoS(i % 2 ? transactions1 : payments);
+            if(i == STORED_BLOCKS / 2) {
+                writerChain.getRegistry().bond("Validator_S", 50);
+            }
+        }
+        store->sync();
+        snapshotTip = writerChain.getLastBlock().getHash();
+        snapshotStateRoot = writerChain.getStateRoot();
+        snapshotStake = writerChain.getRegistry().getStake("Validator_S");
+        StateSnapshot saved;
+        snapshotHeight = StateSnapshot::load(snapshotDirectory, saved) ? saved.height : 0;
+        std::cout << "Instantane ecrit tous les " << SNAPSHOT_INTERVAL << " blocs: "
+                  << (attached && StateSnapshot::load(snapshotDirectory, saved) ? "OUI" : "NON") << ", hauteur "
+                  << saved.height << " sur " << writerChain.getSize() - 1 << std::endl;
+    }
+
+    // The same store reopened with and without its snapshot
+    std::string snapshotFile = StateSnapshot::path(snapshotDirectory);
+    std::string asideFile = snapshotFile + ".aside";
+    auto restart = [&](CompleteBlockchain& node, double& seconds) {
+        node.addValidator("Validator_S", 100, storedKey);
+        auto start = std::chrono::steady_clock::now();
+        std::shared_ptr<BlockStore> store = std::make_shared<BlockStore>(snapshotDirectory, 256 << 10);
+        bool ok = store->open() && node.attachStore(store);
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return ok && node.getLastBlock().getHash() == snapshotTip && node.getStateRoot() == snapshotStateRoot;
+    };
+    double fullSeconds = 0, snapshotSeconds = 0;
+    std::rename(snapshotFile.c_str(), asideFile.c_str());
+    CompleteBlockchain fullNode;
+    bool fullOk = restart(fullNode, fullSeconds);
+    std::rename(asideFile.c_str(), snapshotFile.c_str());
+    CompleteBlockchain fastNode;
+    bool fastOk = restart(fastNode, snapshotSeconds);
+    std::cout << "Sans instantane: " << (fullOk ? "OUI" : "NON") << ", " << fullNode.getReplayedBlocks()
+              << " blocs rejoues en " << std::setprecision(1) << fullSeconds * 1000 << " ms" << std::endl;
+    std::cout << "Avec instantane: " << (fastOk && fastNode.getReplayedBlocks() == (size_t)TAIL_BLOCKS ? "OUI" : "NON")
+              << ", " << fastNode.getReplayedBlocks() << " blocs rejoues en " << snapshotSeconds * 1000 << " ms" << std::endl;
+    std::cout << "Soldes et validateurs restaures: "
+              << (fastNode.getBalance("Alice") == fullNode.getBalance("Alice")
+                  && fastNode.getRegistry().getStake("Validator_S") == snapshotStake ? "OUI" : "NON") << std::endl;
+    // The snapshot only speeds up the state: the stored blocks are checked
+    // again, from the checkpoint at its height
+    std::cout << "Blocs stockes a valider de nouveau: " << (fastNode.getVerifiedHeight() == 1 ? "OUI" : "NON") << std::endl;
+    fastNode.addCheckpoint(snapshotHeight, fastNode.getBlock(snapshotHeight).getHash());
+    bool fastValid = fastNode.isChainValid();
+    std::cout << "Chaine valide apres demarrage rapide, depuis le point de controle " << snapshotHeight << ": "
+              << (fastValid ? "OUI" : "NON") << std::endl;
+    fastNode.addBlockPoS(transactions1);
+    std::cout << "Blocs ajoutes apres redemarrage: " << (fastNode.isChainValid() ? "OUI" : "NON") << std::endl;
+    snapshotTip = fastNode.getLastBlock().getHash();
+    snapshotStateRoot = fastNode.getStateRoot();
+    fastNode = CompleteBlockchain();
+    fullNode = CompleteBlockchain();
+
+    // A damaged snapshot fails its checksum and the whole chain is replayed
+    {
+        std::fstream damaged(snapshotFile.c_str(), std::ios::binary | std::ios::in | std::ios::out);
+        damaged.seekp(100);
+        damaged.put('X');
+    }
+    CompleteBlockchain damagedNode;
+    double damagedSeconds = 0;
+    bool damagedOk = restart(damagedNode, damagedSeconds);
+    std::cout << "Instantane endommage ignore: "
+              << (damagedOk && damagedNode.getReplayedBlocks() == damagedNode.getSize() ? "OUI" : "NON") << std::endl;
+    damagedNode = CompleteBlockchain();
+    StateSnapshot::remove(snapshotDirectory);
+    BlockStore::removeAll(snapshotDirectory);
+
     printSeparator();
     std::cout << "FIN DES TESTS" << std::endl;
 
@@ -12,6 +12,23 @@
 #include <iomanip>
 #include <openssl/sha.h>
 #include <random>
+#include <memory>
+#include <map>
+#include <atomic>
+#include <algorithm>
+#include "../1-ArbredeMerkle/merkle_proof.h"
+#include "../1-ArbredeMerkle/parallel_merkle_tree.h"
+#include "../2-ProofofWork/nonce_search.h"
+#include "../2-ProofofWork/parallel_miner.h"
+#include "../2-ProofofWork/difficulty_retarget.h"
+#include "../3-ProofofStake/validator_registry.h"
+#include "../3-ProofofStake/leader_election.h"
+#include "../0-Common/ed25519.h"
+#include "../0-Common/checkpoints.h"
+#include "sparse_merkle_tree.h"
+#include "block_header.h"
+#include "block_store.h"
+#include "state_snapshot.h"
 
 class Transaction {
 public:
@@ -33,43 +50,88 @@ public:
 
 class MerkleTreeComplete {
 private:
-    std::string calculateHash(const std::string& data) {
-        unsigned char hash[SHA256_DIGEST_LENGTH];
-        SHA256((unsigned char*)data.c_str(), data.size(), hash);
+    std::vector<Digest> nodes;
+    MerkleScratch scratch;
+    // Set by setThreadCount(), shared by copies of this object
+    std::shared_ptr<ParallelMerkleTree> parallelEngine;
 
-        std::stringstream ss;
-        for(int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
-            ss << std::hex << std::setw(2) << std::setfill('0') << (int)hash[i];
+    static const size_t PARALLEL_THRESHOLD = 4096;
+
+    static std::vector<Digest> hashTransactions(const std::vector<Transaction>& transactions) {
+        std::vector<Digest> leaves;
+        leaves.reserve(transactions.size());
+        for(const auto& tx : transactions) {
+            leaves.push_back(MerkleTree::hashLeaf(tx.toString()));
         }
-        return ss.str();
+        return leaves;
     }
 
 public:
+    // Blocks with at least PARALLEL_THRESHOLD transactions are hashed on
+    // this many threads; 1 keeps everything on the calling thread
+    void setThreadCount(unsigned threads) {
+        if(threads <= 1) {
+            parallelEngine.reset();
+        } else {
+            parallelEngine = std::make_shared<ParallelMerkleTree>(threads, MERKLE_HEX_COMPAT);
+        }
+    }
+
     std::string getMerkleRoot(const std::vector<Transaction>& transactions) {
         if(transactions.empty()) {
-            return calculateHash("");
+            return digestToHex(MerkleTree::hashLeaf(""));
         }
 
-        std::vector<std::string> currentLevel;
-        for(const auto& tx : transactions) {
-            currentLevel.push_back(calculateHash(tx.toString()));
+        if(parallelEngine && transactions.size() >= PARALLEL_THRESHOLD) {
+            return digestToHex(parallelEngine->getMerkleRootDigest(transactions, [](const Transaction& tx) {
+                return MerkleTree::hashLeaf(tx.toString());
+            }));
         }
 
-        while(currentLevel.size() > 1) {
-            std::vector<std::string> nextLevel;
+        nodes.resize(transactions.size());
+        for(size_t i = 0; i < transactions.size(); i++) {
+            nodes[i] = MerkleTree::hashLeaf(transactions[i].toString());
+        }
+        return digestToHex(MerkleTree::reduceInPlace(nodes.data(), nodes.size(), MERKLE_HEX_COMPAT, scratch));
+    }
 
-            for(size_t i = 0; i < currentLevel.size(); i += 2) {
-                if(i + 1 < currentLevel.size()) {
-                    nextLevel.push_back(calculateHash(currentLevel[i] + currentLevel[i + 1]));
-                } else {
-                    nextLevel.push_back(calculateHash(currentLevel[i] + currentLevel[i]));
-                }
-            }
+    // Authentication path of transactions[index], checked against the block's merkleRoot
+    MerkleProof getProof(const std::vector<Transaction>& transactions, size_t index) {
+        return makeMerkleProof(buildMerkleLevels(hashTransactions(transactions), MERKLE_HEX_COMPAT), index);
+    }
 
-            currentLevel = nextLevel;
+    MerkleMultiProof getMultiProof(const std::vector<Transaction>& transactions,
+                                   const std::vector<size_t>& indices) {
+        return makeMerkleMultiProof(buildMerkleLevels(hashTransactions(transactions), MERKLE_HEX_COMPAT), indices);
+    }
+
+    static bool verifyTransaction(const Transaction& tx, const MerkleProof& proof,
+                                  const std::string& merkleRoot) {
+        Digest root;
+        return hexToDigest(merkleRoot, root) &&
+               verifyMerkleProof(MerkleTree::hashLeaf(tx.toString()), proof, root);
+    }
+
+    // Checks one proof per transaction in a single pass sharing the upper path nodes
+    static bool verifyTransactions(const std::vector<Transaction>& txs,
+                                   const std::vector<MerkleProof>& proofs,
+                                   const std::string& merkleRoot,
+                                   std::vector<bool>& results) {
+        Digest root;
+        if(!hexToDigest(merkleRoot, root)) {
+            results.assign(proofs.size(), false);
+            return false;
         }
+        return verifyMerkleProofs(hashTransactions(txs), proofs, root, results);
+    }
 
-        return currentLevel[0];
+    // txs[i] must be the transaction at proof.indices[i]
+    static bool verifyMultiProof(const std::vector<Transaction>& txs,
+                                 const MerkleMultiProof& proof,
+                                 const std::string& merkleRoot) {
+        Digest root;
+        return hexToDigest(merkleRoot, root) &&
+               verifyMerkleMultiProof(hashTransactions(txs), proof, root);
     }
 };
 
@@ -79,12 +141,23 @@ private:
     time_t timestamp;
     std::string previousHash;
     std::string merkleRoot;
-    int nonce;
+    uint64_t nonce;
+    // Incremented when the nonce space of the header is exhausted (version 3)
+    uint32_t extraNonce;
     std::string hash;
     std::vector<Transaction> transactions;
     std::string validatorAddress;
+    // Root of the account state after this block; empty for blocks made
+    // before state roots existed, which keeps their preimage unchanged
+    std::string stateRoot;
+    // Target of PoW blocks, in the binary header but not in the text
+    // preimage; PoS blocks keep the default target that every hash meets
+    DifficultyTarget target;
+    uint32_t version;
+    // PoS blocks: the validator's Ed25519 signature of the hash, not part of it
+    Signature signature;
 
-    std::string calculateHash(const std::string& input) {
+    std::string calculateHash(const std::string& input) const {
         unsigned char hash[SHA256_DIGEST_LENGTH];
         SHA256((unsigned char*)input.c_str(), input.size(), hash);
 
@@ -95,25 +168,272 @@ private:
         return ss.str();
     }
 
+    // Hex fields that are not a digest (the genesis previousHash "0", no
+    // state root) encode as zeros; hasCanonicalFields() rejects any other
+    static Digest digestOrZero(const std::string& hex) {
+        Digest out;
+        if(!hexToDigest(hex, out)) {
+            out.fill(0);
+        }
+        return out;
+    }
+
+    static void putUint(std::vector<uint8_t>& out, uint64_t value, size_t bytes) {
+        out.resize(out.size() + bytes);
+        BlockHeader::writeUint(&out[out.size() - bytes], value, bytes);
+    }
+
+    // A lowercase hex digest as 0 then its 32 bytes, any other text as 1,
+    // its length in 7-bit groups, then its characters
+    static void putField(std::vector<uint8_t>& out, const std::string& text) {
+        Digest digest;
+        if(isCanonicalDigest(text, digest)) {
+            out.push_back(0);
+            out.insert(out.end(), digest.begin(), digest.end());
+            return;
+        }
+        out.push_back(1);
+        uint64_t length = text.size();
+        for(; length >= 0x80; length >>= 7) {
+            out.push_back((uint8_t)(length | 0x80));
+        }
+        out.push_back((uint8_t)length);
+        out.insert(out.end(), text.begin(), text.end());
+    }
+
+    // Bounds-checked cursor over an encoded block
+    struct Reader {
+        const uint8_t* position;
+        const uint8_t* end;
+
+        bool take(size_t bytes, const uint8_t*& at) {
+            if((size_t)(end - position) < bytes) {
+                return false;
+            }
+            at = position;
+            position += bytes;
+            return true;
+        }
+
+        bool getUint(size_t bytes, uint64_t& value) {
+            const uint8_t* at;
+            if(!take(bytes, at)) {
+                return false;
+            }
+            value = BlockHeader::readUint(at, bytes);
+            return true;
+        }
+
+        bool getField(std::string& text) {
+            const uint8_t* at;
+            if(!take(1, at)) {
+                return false;
+            }
+            if(*at == 0) {
+                Digest digest;
+                if(!take(digest.size(), at)) {
+                    return false;
+                }
+                std::memcpy(digest.data(), at, digest.size());
+                text = digestToHex(digest);
+                return true;
+            }
+            uint64_t length = 0;
+            for(int shift = 0; ; shift += 7) {
+                if(shift > 56 || !take(1, at)) {
+                    return false;
+                }
+                length |= (uint64_t)(*at & 0x7f) << shift;
+                if(!(*at & 0x80)) {
+                    break;
+                }
+            }
+            if(!take(length, at)) {
+                return false;
+            }
+            text.assign((const char*)at, length);
+            return true;
+        }
+    };
+
+    // 64 lowercase hex digits
+    static bool isCanonicalDigest(const std::string& hex, Digest& digest) {
+        return hexToDigest(hex, digest) && digestToHex(digest) == hex;
+    }
+
+    static bool isCanonicalDigest(const std::string& hex) {
+        Digest digest;
+        return isCanonicalDigest(hex, digest);
+    }
+
+    // Legacy text preimage, up to and without the nonce
+    std::string textPrefix() const {
+        std::stringstream ss;
+        ss << index << timestamp << previousHash << merkleRoot;
+        return ss.str();
+    }
+
 public:
+    // Empty block, to be filled by decode
+    BlockComplete() : index(0), timestamp(0), nonce(0), extraNonce(0), version(BLOCK_VERSION_WIDE_NONCE) {
+        signature.fill(0);
+    }
+
     BlockComplete(int idx, const std::string& prevHash,
                   const std::vector<Transaction>& txs)
             : index(idx), previousHash(prevHash), transactions(txs),
-              nonce(0), validatorAddress("") {
+              nonce(0), extraNonce(0), validatorAddress(""), version(BLOCK_VERSION_WIDE_NONCE) {
         timestamp = time(nullptr);
+        signature.fill(0);
 
         MerkleTreeComplete merkle;
         merkleRoot = merkle.getMerkleRoot(transactions);
         hash = "";
     }
 
+    BlockComplete(int idx, const std::string& prevHash,
+                  const std::vector<Transaction>& txs, MerkleTreeComplete& merkle)
+            : index(idx), previousHash(prevHash), transactions(txs),
+              nonce(0), extraNonce(0), validatorAddress(""), version(BLOCK_VERSION_WIDE_NONCE) {
+        timestamp = time(nullptr);
+        signature.fill(0);
+        merkleRoot = merkle.getMerkleRoot(transactions);
+        hash = "";
+    }
+
+    BlockHeader getHeader() const {
+        BlockHeader header;
+        header.version = version;
+        header.index = (uint32_t)index;
+        header.timestamp = (int64_t)timestamp;
+        header.previousHash = digestOrZero(previousHash);
+        header.merkleRoot = digestOrZero(merkleRoot);
+        header.stateRoot = digestOrZero(stateRoot);
+        header.target = target.getMaximum();
+        if(!validatorAddress.empty()) {
+            header.validatorId = sha256Digest(validatorAddress);
+            if(BlockHeader::isWide(version)) {
+                std::fill(header.validatorId.begin() + 20, header.validatorId.end(), 0);
+            }
+        }
+        header.extraNonce = extraNonce;
+        header.nonce = nonce;
+        return header;
+    }
+
+    // Only the nonce varies between candidates, so they are hashed in
+    // multi-buffer batches from the midstate of the constant part. In
+    // version 3, once the nonces up to nonceLimit (by default the whole
+    // 64 bits) are exhausted the extra nonce rolls over and the search
+    // restarts at nonce 0. Leaves hash empty if the whole space fails.
+    void mineBlock(const DifficultyTarget& blockTarget, uint64_t nonceLimit = UINT64_MAX) {
+        target = blockTarget;
+        uint64_t found = 0;
+        if(version == BLOCK_VERSION_TEXT) {
+            if(findNonceBatched(textPrefix(), validatorAddress + stateRoot, nonce, target, found, hash)) {
+                nonce = found;
+            }
+            return;
+        }
+
+        uint64_t lastNonce = std::min(nonceLimit, BlockHeader::maxNonceOf(version));
+        uint32_t lastExtra = BlockHeader::isWide(version) ? UINT32_MAX : 0;
+        uint64_t first = nonce + 1;
+        uint32_t extra = extraNonce;
+        if(nonce >= lastNonce) {
+            if(extra == lastExtra) {
+                hash = "";
+                return;
+            }
+            extra++;
+            first = 0;
+        }
+
+        uint8_t header[BlockHeader::MAX_SIZE];
+        while(true) {
+            BlockHeader candidate = getHeader();
+            candidate.extraNonce = extra;
+            candidate.encode(header);
+            uint64_t hashes = 0;
+            if(findHeaderNonceInRange(header, candidate.size(), candidate.nonceOffset(),
+                                      BlockHeader::nonceBytesOf(version), first, lastNonce,
+                                      target, found, hash, hashes)) {
+                extraNonce = extra;
+                nonce = found;
+                return;
+            }
+            if(extra == lastExtra) {
+                hash = "";
+                return;
+            }
+            extra++;
+            first = 0;
+        }
+    }
+
+    // difficulty = number of leading '0' in the hex hash
     void mineBlock(int difficulty) {
-        std::string target(difficulty, '0');
+        mineBlock(DifficultyTarget::fromHexZeros(difficulty));
+    }
+
+    // Same result as mineBlock, searched by all the miner's threads, which
+    // get disjoint (extra nonce, nonce) ranges.
+    // Leaves the block unchanged if cancel is raised before a solution is found.
+    MiningResult mineBlockParallel(const DifficultyTarget& blockTarget, ParallelMiner& miner,
+                                   const std::atomic<bool>* cancel = nullptr,
+                                   uint64_t nonceLimit = UINT64_MAX) {
+        MiningResult result;
+        if(version == BLOCK_VERSION_TEXT) {
+            std::string prefix = textPrefix();
+            std::string suffix = validatorAddress + stateRoot;
+            result = miner.mine(
+                    [&](uint64_t first, uint64_t last, uint64_t& found, std::string& foundHash, uint64_t& hashes) {
+                        return findNonceInRange(prefix, suffix, first, last, blockTarget, found, foundHash, hashes);
+                    },
+                    nonce + 1, UINT64_MAX, cancel);
+        } else {
+            uint64_t lastNonce = std::min(nonceLimit, BlockHeader::maxNonceOf(version));
+            uint32_t lastExtra = BlockHeader::isWide(version) ? UINT32_MAX : 0;
+            uint64_t first = nonce + 1;
+            uint32_t firstExtra = extraNonce;
+            if(nonce >= lastNonce) {
+                if(firstExtra == lastExtra) {
+                    return result;
+                }
+                firstExtra++;
+                first = 0;
+            }
+
+            BlockHeader candidate = getHeader();
+            candidate.target = blockTarget.getMaximum();
+            size_t size = candidate.size();
+            size_t nonceOffset = candidate.nonceOffset();
+            size_t nonceBytes = BlockHeader::nonceBytesOf(version);
+            result = miner.mineExtended(
+                    [&](uint32_t extra, uint64_t from, uint64_t to, uint64_t& found, std::string& foundHash,
+                        uint64_t& hashes) {
+                        BlockHeader withExtra = candidate;
+                        withExtra.extraNonce = extra;
+                        uint8_t header[BlockHeader::MAX_SIZE];
+                        withExtra.encode(header);
+                        return findHeaderNonceInRange(header, size, nonceOffset, nonceBytes, from, to,
+                                                      blockTarget, found, foundHash, hashes);
+                    },
+                    firstExtra, lastExtra, first, lastNonce, cancel);
+        }
+
+        if(result.found) {
+            extraNonce = result.extraNonce;
+            nonce = result.nonce;
+            hash = result.hash;
+            target = blockTarget;
+        }
+        return result;
+    }
 
-        do {
-            nonce++;
-            hash = calculateBlockHash();
-        } while (hash.substr(0, difficulty) != target);
+    MiningResult mineBlockParallel(int difficulty, ParallelMiner& miner,
+                                   const std::atomic<bool>* cancel = nullptr) {
+        return mineBlockParallel(DifficultyTarget::fromHexZeros(difficulty), miner, cancel);
     }
 
     void validateBlockPoS(const std::string& validator) {
@@ -121,119 +441,786 @@ public:
         hash = calculateBlockHash();
     }
 
-    std::string calculateBlockHash() {
+    // After validateBlockPoS, with the validator's key
+    void sign(const Ed25519Key& key) {
+        signature = key.sign(digestOrZero(hash));
+    }
+
+    SignatureCheck signatureCheck(const PublicKey& publicKey) const {
+        SignatureCheck check;
+        check.publicKey = publicKey;
+        check.message = digestOrZero(hash);
+        check.signature = signature;
+        return check;
+    }
+
+    std::string calculateBlockHash() const {
+        if(version != BLOCK_VERSION_TEXT) {
+            return digestToHex(getHeader().hash());
+        }
         std::stringstream ss;
-        ss << index << timestamp << previousHash << merkleRoot << nonce << validatorAddress;
+        ss << index << timestamp << previousHash << merkleRoot << nonce << validatorAddress << stateRoot;
         return calculateHash(ss.str());
     }
 
-    std::string getHash() const { return hash; }
+    // A binary header holds the bytes of the digests, so a field that is
+    // not exactly one digest would not be covered by the hash: only the
+    // genesis previousHash "0" and an empty state root may be zeros. Text
+    // blocks hash the strings themselves and always pass.
+    bool hasCanonicalFields() const {
+        return version == BLOCK_VERSION_TEXT
+               || ((isCanonicalDigest(previousHash) || (index == 0 && previousHash == "0"))
+                   && isCanonicalDigest(merkleRoot)
+                   && (stateRoot.empty() || isCanonicalDigest(stateRoot)));
+    }
+
+    const std::string& getHash() const { return hash; }
     int getIndex() const { return index; }
-    std::string getPreviousHash() const { return previousHash; }
-    std::string getMerkleRoot() const { return merkleRoot; }
-    int getNonce() const { return nonce; }
+    const std::string& getPreviousHash() const { return previousHash; }
+    const std::string& getMerkleRoot() const { return merkleRoot; }
+    uint64_t getNonce() const { return nonce; }
+    uint32_t getExtraNonce() const { return extraNonce; }
     time_t getTimestamp() const { return timestamp; }
-    std::string getValidator() const { return validatorAddress; }
+    const std::string& getValidator() const { return validatorAddress; }
+    const std::string& getStateRoot() const { return stateRoot; }
+    const DifficultyTarget& getTarget() const { return target; }
+    bool meetsTarget() const { return target.isMetByHex(hash); }
+    uint32_t getVersion() const { return version; }
+    const Signature& getSignature() const { return signature; }
     const std::vector<Transaction>& getTransactions() const { return transactions; }
-};
 
-class ValidatorComplete {
-public:
-    std::string address;
-    int stake;
+    // Must be called before mining or validating, the root is part of the hash
+    void setStateRoot(const std::string& root) { stateRoot = root; }
+    // BLOCK_VERSION_TEXT keeps the preimage of blocks made before the binary header
+    void setVersion(uint32_t blockVersion) { version = blockVersion; }
+
+    // Binary form kept by BlockStore, integers big-endian: version 4,
+    // index 4, timestamp 8, nonce 8, extra nonce 4, target 32, then the
+    // fields hash, previous hash, Merkle root, state root and validator
+    // (see putField), the signature (64, PoS blocks only), the number of
+    // transactions (4) and for each its id, sender and receiver fields
+    // and its amount as the 8 bytes of the double.
+    void encode(std::vector<uint8_t>& out) const {
+        putUint(out, version, 4);
+        putUint(out, (uint32_t)index, 4);
+        putUint(out, (uint64_t)(int64_t)timestamp, 8);
+        putUint(out, nonce, 8);
+        putUint(out, extraNonce, 4);
+        const Digest& maximum = target.getMaximum();
+        out.insert(out.end(), maximum.begin(), maximum.end());
+        putField(out, hash);
+        putField(out, previousHash);
+        putField(out, merkleRoot);
+        putField(out, stateRoot);
+        putField(out, validatorAddress);
+        if(!validatorAddress.empty()) {
+            out.insert(out.end(), signature.begin(), signature.end());
+        }
+        putUint(out, transactions.size(), 4);
+        for(const auto& tx : transactions) {
+            putField(out, tx.id);
+            putField(out, tx.sender);
+            putField(out, tx.receiver);
+            uint64_t bits;
+            std::memcpy(&bits, &tx.amount, sizeof(bits));
+            putUint(out, bits, 8);
+        }
+    }
 
-    ValidatorComplete(const std::string& addr, int stakeAmount)
-            : address(addr), stake(stakeAmount) {}
+    // Returns false if the bytes are not exactly one encoded block
+    static bool decode(const uint8_t* data, size_t size, BlockComplete& out) {
+        Reader in;
+        in.position = data;
+        in.end = data + size;
+        uint64_t value;
+        const uint8_t* at;
+        if(!in.getUint(4, value)) {
+            return false;
+        }
+        out.version = (uint32_t)value;
+        if(!in.getUint(4, value)) {
+            return false;
+        }
+        out.index = (int)(uint32_t)value;
+        if(!in.getUint(8, value)) {
+            return false;
+        }
+        out.timestamp = (time_t)(int64_t)value;
+        if(!in.getUint(8, out.nonce) || !in.getUint(4, value)) {
+            return false;
+        }
+        out.extraNonce = (uint32_t)value;
+        Digest maximum;
+        if(!in.take(maximum.size(), at)) {
+            return false;
+        }
+        std::memcpy(maximum.data(), at, maximum.size());
+        out.target = DifficultyTarget(maximum);
+        if(!in.getField(out.hash) || !in.getField(out.previousHash) || !in.getField(out.merkleRoot)
+           || !in.getField(out.stateRoot) || !in.getField(out.validatorAddress)) {
+            return false;
+        }
+        out.signature.fill(0);
+        if(!out.validatorAddress.empty()) {
+            if(!in.take(out.signature.size(), at)) {
+                return false;
+            }
+            std::memcpy(out.signature.data(), at, out.signature.size());
+        }
+        if(!in.getUint(4, value)) {
+            return false;
+        }
+        out.transactions.clear();
+        out.transactions.reserve((size_t)std::min<uint64_t>(value, size));
+        for(uint64_t t = 0; t < value; t++) {
+            std::string id, sender, receiver;
+            uint64_t bits;
+            if(!in.getField(id) || !in.getField(sender) || !in.getField(receiver) || !in.getUint(8, bits)) {
+                return false;
+            }
+            double amount;
+            std::memcpy(&amount, &bits, sizeof(amount));
+            out.transactions.push_back(Transaction(id, sender, receiver, amount));
+        }
+        return in.position == in.end;
+    }
 };
 
+typedef ValidatorRecord ValidatorComplete;
+
 class CompleteBlockchain {
 private:
     std::vector<BlockComplete> chain;
-    std::vector<ValidatorComplete> validators;
-    std::mt19937 rng;
+    ValidatorRegistry validators;
+    // validatorSets[i]: the validators when block i was added, from which
+    // the leader of its slot is re-derived
+    std::vector<ValidatorSnapshot> validatorSets;
+    // headers[i] is chain[i].getHeader(), for walking the chain without
+    // touching transactions or strings
+    std::vector<BlockHeader> headers;
+    // Blocks below it passed isChainValid; blocks are never modified, so
+    // they need not be checked again
+    size_t verifiedHeight;
+    Checkpoints checkpoints;
+    // Set by attachStore(); every appended block is written to it
+    std::shared_ptr<BlockStore> store;
+    // Every snapshotInterval-th block appended to the store, a state
+    // snapshot is saved next to it; 0 saves none
+    uint64_t snapshotInterval;
+    // Blocks whose transactions the last attachStore() replayed
+    size_t replayedBlocks;
+    // Keys of the validators this node signs for
+    std::map<std::string, Ed25519Key> signingKeys;
+    std::shared_ptr<SignatureVerifier> verifier;
+    std::mt19937_64 rng;
+    MerkleTreeComplete merkle;
+    SparseMerkleTree state;
+    std::shared_ptr<ParallelMiner> miner;
+    // Set by setValidationThreads(), shared by copies of this chain
+    std::shared_ptr<ThreadPool> validationPool;
+    MiningResult lastMining;
+    uint32_t blockVersion;
+    // PoW targets from chain[retargetStart] on come from the retargeter
+    bool retargeting;
+    size_t retargetStart;
+    DifficultyRetargeter retargeter;
+
+    // Blocks handed to a validation thread at a time
+    static const size_t VALIDATION_CHUNK = 256;
+
+    // A block is PoS when it names a validator, which its hash commits to;
+    // PoS blocks do not take part in retargeting
+    static bool isProofOfWork(const BlockComplete& block) {
+        return block.getValidator().empty();
+    }
+
+    // New balances of every account touched by the transactions, applied in order
+    static std::vector<std::pair<std::string, double> > balanceUpdates(const SparseMerkleTree& base,
+                                                                        const std::vector<Transaction>& transactions) {
+        std::map<std::string, double> balances;
+        for(const auto& tx : transactions) {
+            if(balances.find(tx.sender) == balances.end()) {
+                balances[tx.sender] = base.getBalance(tx.sender);
+            }
+            balances[tx.sender] -= tx.amount;
+            if(balances.find(tx.receiver) == balances.end()) {
+                balances[tx.receiver] = base.getBalance(tx.receiver);
+            }
+            balances[tx.receiver] += tx.amount;
+        }
+        return std::vector<std::pair<std::string, double> >(balances.begin(), balances.end());
+    }
+
+    // Balances of the accounts in updates before they are applied: applying
+    // them afterwards gives the same state, and the same root, back
+    std::vector<std::pair<std::string, double> > previousBalances(
+            const std::vector<std::pair<std::string, double> >& updates) const {
+        std::vector<std::pair<std::string, double> > previous;
+        previous.reserve(updates.size());
+        for(const auto& entry : updates) {
+            previous.push_back(std::make_pair(entry.first, state.getBalance(entry.first)));
+        }
+        return previous;
+    }
+
+    // Returns what undoes it (see previousBalances)
+    std::vector<std::pair<std::string, double> > applyState(BlockComplete& block) {
+        std::vector<std::pair<std::string, double> > updates = balanceUpdates(state, block.getTransactions());
+        std::vector<std::pair<std::string, double> > undo = previousBalances(updates);
+        state.applyBatch(updates);
+        block.setStateRoot(state.getRoot());
+        return undo;
+    }
+
+    bool storeBlock(const BlockComplete& block) {
+        std::vector<uint8_t> bytes;
+        block.encode(bytes);
+        Digest hash;
+        if(!hexToDigest(block.getHash(), hash)) {
+            hash.fill(0);
+        }
+        return store->append(block.getIndex(), hash, bytes);
+    }
+
+    // Returns false, appending nothing, if the block cannot be written to
+    // the attached store
+    bool appendBlock(BlockComplete block) {
+        if(store && !storeBlock(block)) {
+            return false;
+        }
+        headers.push_back(block.getHeader());
+        chain.push_back(std::move(block));
+        validatorSets.push_back(validators.snapshot());
+        if(store && snapshotInterval != 0 && chain.size() % snapshotInterval == 0) {
+            saveSnapshot();
+        }
+        return true;
+    }
+
+    // Rebuilds the state of a snapshot matching the loaded chain: the block
+    // at its height has its hash and state root, and the balances give that
+    // root back. Returns false, leaving everything unchanged, otherwise.
+    bool restoreSnapshot(const StateSnapshot& snapshot, const std::vector<BlockComplete>& loaded) {
+        if(snapshot.height >= loaded.size()) {
+            return false;
+        }
+        const BlockComplete& tip = loaded[snapshot.height];
+        std::string root = digestToHex(snapshot.stateRoot);
+        if(tip.getHash() != digestToHex(snapshot.tipHash) || tip.getStateRoot() != root) {
+            return false;
+        }
+        SparseMerkleTree restored;
+        restored.applyBatch(snapshot.balances);
+        if(restored.getRoot() != root) {
+            return false;
+        }
+        state = std::move(restored);
+        validators.restore(snapshot.validators, snapshot.unbondings);
+        return true;
+    }
+
+    // The slot of a block is its index; PoW blocks have no leader
+    bool isProposerValid(size_t i, const BlockComplete& block) const {
+        return isProofOfWork(block)
+               || block.getValidator() == electLeader(validatorSets[i], block.getPreviousHash(), block.getIndex());
+    }
+
+    // The retargeter as it stood when block height was added; only the last
+    // window PoW blocks before it matter
+    DifficultyRetargeter retargeterAt(size_t height) const {
+        const RetargetParams& params = retargeter.getParams();
+        DifficultyRetargeter replay(params);
+        std::vector<size_t> recent;
+        size_t first = std::max<size_t>(retargetStart, 1);
+        for(size_t i = height; i > first && recent.size() < params.window; i--) {
+            if(isProofOfWork(chain[i - 1])) {
+                recent.push_back(i - 1);
+            }
+        }
+        for(std::vector<size_t>::reverse_iterator it = recent.rbegin(); it != recent.rend(); ++it) {
+            replay.recordBlock((double)chain[*it].getTimestamp(), chain[*it].getTarget());
+        }
+        return replay;
+    }
+
+    // Everything about block i but retargeting and the signature itself,
+    // whose check is appended to signatures
+    bool isBlockValid(size_t i, MerkleTreeComplete& tree, std::vector<SignatureCheck>& signatures) const {
+        const BlockComplete& block = chain[i];
+        return block.hasCanonicalFields()
+               && block.getHash() == block.calculateBlockHash()
+               && block.meetsTarget()
+               && block.getPreviousHash() == chain[i - 1].getHash()
+               && block.getMerkleRoot() == tree.getMerkleRoot(block.getTransactions())
+               && isProposerValid(i, block)
+               && expectedSignature(validatorSets[i], block, signatures);
+    }
+
+    // Signature a PoS block must carry; false if its validator has no
+    // registered key
+    static bool expectedSignature(const ValidatorSnapshot& set, const BlockComplete& block,
+                                  std::vector<SignatureCheck>& checks) {
+        if(isProofOfWork(block)) {
+            return true;
+        }
+        const ValidatorRecord* proposer = set.find(block.getValidator());
+        if(proposer == nullptr || !proposer->hasPublicKey()) {
+            return false;
+        }
+        checks.push_back(block.signatureCheck(proposer->publicKey));
+        return true;
+    }
 
 public:
-    CompleteBlockchain() : rng(std::random_device{}()) {
-        chain.push_back(createGenesisBlock());
+    CompleteBlockchain() : rng(std::random_device{}()), verifier(std::make_shared<SignatureVerifier>()),
+                           verifiedHeight(1), snapshotInterval(0), replayedBlocks(0),
+                           blockVersion(BLOCK_VERSION_WIDE_NONCE), retargeting(false), retargetStart(0) {
+        appendBlock(createGenesisBlock());
     }
 
     BlockComplete createGenesisBlock() {
         std::vector<Transaction> genesisTxs;
         genesisTxs.push_back(Transaction("TX0", "Genesis", "Genesis", 0));
         BlockComplete genesis(0, "0", genesisTxs);
+        genesis.setVersion(blockVersion);
+        applyState(genesis);
         genesis.validateBlockPoS("Genesis");
         return genesis;
     }
 
-    BlockComplete getLastBlock() {
+    const BlockComplete& getLastBlock() const {
         return chain.back();
     }
 
-    void addValidator(const std::string& address, int stake) {
-        validators.push_back(ValidatorComplete(address, stake));
+    // Threads used for the Merkle root of large blocks, when adding and validating
+    void setMerkleThreads(unsigned threads) {
+        merkle.setThreadCount(threads);
     }
 
-    std::string selectValidator() {
-        if(validators.empty()) {
-            return "";
+    // Threads searching nonces in addBlockPoW; 1 keeps the serial loop
+    void setMiningThreads(unsigned threads) {
+        if(threads <= 1) {
+            miner.reset();
+        } else {
+            miner = std::make_shared<ParallelMiner>(threads);
         }
+    }
 
-        int totalStake = 0;
-        for(const auto& v : validators) {
-            totalStake += v.stake;
+    // From now on every appended block is also written to blockStore,
+    // which must be open; store->good() turns false on a write error. An
+    // empty store receives the current chain. Otherwise the chain is
+    // replaced by the stored blocks and the state rebuilt from their
+    // transactions, with the validators added so far; the blocks are not
+    // validated, isChainValid or a checkpoint does that. Returns false,
+    // leaving the chain unchanged, if a stored block cannot be decoded.
+    //
+    // If the store holds a snapshot of a block still in the chain (same
+    // hash, same state root), the balances and validators come from it
+    // and only the blocks after it are replayed.
+    //
+    // Validator sets are not stored: every reloaded block gets the current
+    // one, so the leaders and signatures of PoS blocks made before the last
+    // stake or key change cannot be checked again: a checkpoint above that
+    // change, e.g. at the snapshot height, makes isChainValid start after it.
+    bool attachStore(const std::shared_ptr<BlockStore>& blockStore) {
+        if(blockStore->size() == 0) {
+            store = blockStore;
+            for(const auto& block : chain) {
+                storeBlock(block);
+            }
+            return store->good();
         }
 
-        std::uniform_int_distribution<int> dist(0, totalStake - 1);
-        int randomValue = dist(rng);
-
-        int cumulativeStake = 0;
-        for(const auto& v : validators) {
-            cumulativeStake += v.stake;
-            if(randomValue < cumulativeStake) {
-                return v.address;
+        std::vector<BlockComplete> loaded(blockStore->size());
+        for(uint64_t height = 0; height < loaded.size(); height++) {
+            const uint8_t* data;
+            size_t length;
+            if(!blockStore->readRecord(height, data, length) || !BlockComplete::decode(data, length, loaded[height])) {
+                return false;
             }
         }
+        StateSnapshot snapshot;
+        size_t replayFrom = 0;
+        verifiedHeight = 1;
+        if(StateSnapshot::load(blockStore->getDirectory(), snapshot) && restoreSnapshot(snapshot, loaded)) {
+            replayFrom = snapshot.height + 1;
+        } else {
+            state = SparseMerkleTree();
+        }
+        chain.swap(loaded);
+        headers.clear();
+        validatorSets.clear();
+        for(size_t height = replayFrom; height < chain.size(); height++) {
+            state.applyBatch(balanceUpdates(state, chain[height].getTransactions()));
+        }
+        for(const auto& block : chain) {
+            headers.push_back(block.getHeader());
+            validatorSets.push_back(validators.snapshot());
+        }
+        replayedBlocks = chain.size() - replayFrom;
+        if(retargeting) {
+            retargeter = retargeterAt(chain.size());
+        }
+        store = blockStore;
+        return true;
+    }
 
-        return validators[0].address;
+    // From now on every blocks-th block written to the store saves a
+    // snapshot of the state with it, replacing the previous one; 0 stops
+    void setSnapshotInterval(uint64_t blocks) { snapshotInterval = blocks; }
+
+    // Saves the state at the tip next to the attached store, after syncing
+    // the store so that the blocks it covers are on disk. Returns false if
+    // there is no store or a write fails.
+    bool saveSnapshot() {
+        if(!store || !store->good()) {
+            return false;
+        }
+        store->sync();
+        StateSnapshot snapshot;
+        snapshot.height = chain.size() - 1;
+        if(!hexToDigest(chain.back().getHash(), snapshot.tipHash)) {
+            return false;
+        }
+        snapshot.stateRoot = state.getRootDigest();
+        state.forEachAccount([&snapshot](const std::string& address, double balance) {
+            snapshot.balances.push_back(std::make_pair(address, balance));
+        });
+        std::sort(snapshot.balances.begin(), snapshot.balances.end());
+        snapshot.validators = validators.getValidators();
+        snapshot.unbondings = validators.getUnbondings();
+        return snapshot.save(store->getDirectory());
     }
 
-    void addBlockPoW(const std::vector<Transaction>& transactions, int difficulty) {
-        BlockComplete newBlock(chain.size(), getLastBlock().getHash(), transactions);
-        newBlock.mineBlock(difficulty);
-        chain.push_back(newBlock);
+    size_t getReplayedBlocks() const { return replayedBlocks; }
+
+    // Threads checking blocks in isChainValid; 1 keeps the serial loop.
+    // Signatures are verified on setVerifyThreads threads.
+    void setValidationThreads(unsigned threads) {
+        if(threads <= 1) {
+            validationPool.reset();
+        } else {
+            validationPool = std::make_shared<ThreadPool>(threads);
+        }
     }
 
-    void addBlockPoS(const std::vector<Transaction>& transactions) {
-        BlockComplete newBlock(chain.size(), getLastBlock().getHash(), transactions);
-        std::string validator = selectValidator();
-        newBlock.validateBlockPoS(validator);
-        chain.push_back(newBlock);
+    // From the next block on, PoW targets follow the observed block times
+    // to keep about params.blockSeconds between blocks
+    void enableRetargeting(const RetargetParams& params) {
+        retargeting = true;
+        retargetStart = chain.size();
+        retargeter = DifficultyRetargeter(params);
     }
 
-    bool isChainValid() {
-        for(size_t i = 1; i < chain.size(); i++) {
-            BlockComplete currentBlock = chain[i];
-            BlockComplete previousBlock = chain[i - 1];
+    // Without retargeting, the initial target of the default RetargetParams
+    DifficultyTarget getNextTarget() const {
+        return retargeter.nextTarget();
+    }
 
-            if(currentBlock.getHash() != currentBlock.calculateBlockHash()) {
-                return false;
+    // Preimage format of the blocks added from now on; blocks already in
+    // the chain keep theirs and still validate
+    void setBlockVersion(uint32_t version) { blockVersion = version; }
+
+    // Hash rates of the last block mined with several threads
+    const MiningResult& getLastMiningResult() const { return lastMining; }
+
+    // A validator added twice has its stakes added up. A new validator
+    // gets a new key pair, kept by this node to sign its blocks.
+    void addValidator(const std::string& address, uint64_t stake) {
+        if(validators.find(address) != nullptr) {
+            validators.bond(address, stake);
+        } else {
+            addValidator(address, stake, Ed25519Key::generate());
+        }
+    }
+
+    void addValidator(const std::string& address, uint64_t stake, const Ed25519Key& key) {
+        validators.bond(address, stake);
+        validators.setPublicKey(address, key.publicKey());
+        signingKeys[address] = key;
+    }
+
+    // Threads verifying block signatures in isChainValid
+    void setVerifyThreads(unsigned threads) { verifier->setThreadCount(threads); }
+
+    SignatureVerifier& getVerifier() { return *verifier; }
+
+    // O(1) selection until the next stake change, for a frozen epoch
+    void freezeStakes() { validators.freeze(); }
+
+    // Stake changes, unbonding and slashing
+    ValidatorRegistry& getRegistry() { return validators; }
+
+    // Probability proportional to stake, O(log n); "" if no stake at all
+    std::string selectValidator() {
+        return validators.sample(rng);
+    }
+
+    // Leader of the slot after previousHash, the same on every node
+    std::string electValidator(const std::string& previousHash, uint64_t slot) const {
+        return electLeader(validators.snapshot(), previousHash, slot);
+    }
+
+    // Once retargeting is enabled the target argument is ignored: every
+    // PoW block uses getNextTarget(), which isChainValid checks
+    // The addBlock* methods return false, leaving the chain and the state
+    // unchanged, if the block cannot be written to the attached store
+    bool addBlockPoW(const std::vector<Transaction>& transactions, const DifficultyTarget& target) {
+        BlockComplete newBlock(chain.size(), getLastBlock().getHash(), transactions, merkle);
+        newBlock.setVersion(blockVersion);
+        std::vector<std::pair<std::string, double> > undo = applyState(newBlock);
+        DifficultyTarget blockTarget = retargeting ? retargeter.nextTarget() : target;
+        if(miner) {
+            lastMining = newBlock.mineBlockParallel(blockTarget, *miner);
+        } else {
+            newBlock.mineBlock(blockTarget);
+        }
+        double timestamp = (double)newBlock.getTimestamp();
+        if(!appendBlock(std::move(newBlock))) {
+            state.applyBatch(undo);
+            return false;
+        }
+        if(retargeting) {
+            retargeter.recordBlock(timestamp, blockTarget);
+        }
+        return true;
+    }
+
+    bool addBlockPoW(const std::vector<Transaction>& transactions) {
+        return addBlockPoW(transactions, getNextTarget());
+    }
+
+    // Next block on the current tip, state root included, ready to be mined
+    // elsewhere (MiningService) and handed back to addMinedBlock
+    BlockComplete createBlockTemplate(const std::vector<Transaction>& transactions) {
+        BlockComplete newBlock(chain.size(), getLastBlock().getHash(), transactions, merkle);
+        newBlock.setVersion(blockVersion);
+        // Applied for the root then undone: the state does not move
+        state.applyBatch(applyState(newBlock));
+        return newBlock;
+    }
+
+    // Appends a block mined from createBlockTemplate. Returns false, leaving
+    // the chain unchanged, if the block is stale (not on the tip), invalid
+    // or cannot be written to the attached store.
+    bool addMinedBlock(const BlockComplete& block) {
+        if(block.getIndex() != (int)chain.size() || block.getPreviousHash() != chain.back().getHash()
+           || block.getHash().empty() || !block.hasCanonicalFields()
+           || block.getHash() != block.calculateBlockHash() || !block.meetsTarget()
+           || block.getMerkleRoot() != merkle.getMerkleRoot(block.getTransactions())) {
+            return false;
+        }
+        if(retargeting && isProofOfWork(block) && block.getTarget() != retargeter.nextTarget()) {
+            return false;
+        }
+        if(!isProofOfWork(block)
+           && block.getValidator() != electLeader(validators.snapshot(), block.getPreviousHash(), block.getIndex())) {
+            return false;
+        }
+        std::vector<SignatureCheck> signature;
+        if(!expectedSignature(validators.snapshot(), block, signature) || !verifier->verifyBatch(signature)) {
+            return false;
+        }
+        std::vector<std::pair<std::string, double> > updates = balanceUpdates(state, block.getTransactions());
+        std::vector<std::pair<std::string, double> > undo = previousBalances(updates);
+        state.applyBatch(updates);
+        if(block.getStateRoot() != state.getRoot() || !appendBlock(block)) {
+            state.applyBatch(undo);
+            return false;
+        }
+        if(retargeting && isProofOfWork(block)) {
+            retargeter.recordBlock((double)block.getTimestamp(), block.getTarget());
+        }
+        return true;
+    }
+
+    // difficulty = number of leading '0' in the hex hash
+    bool addBlockPoW(const std::vector<Transaction>& transactions, int difficulty) {
+        return addBlockPoW(transactions, DifficultyTarget::fromHexZeros(difficulty));
+    }
+
+    // Returns false, adding nothing, if there is no validator to elect
+    bool addBlockPoS(const std::vector<Transaction>& transactions) {
+        BlockComplete newBlock(chain.size(), getLastBlock().getHash(), transactions, merkle);
+        std::string leader = electValidator(newBlock.getPreviousHash(), newBlock.getIndex());
+        if(leader.empty()) {
+            return false;
+        }
+        newBlock.setVersion(blockVersion);
+        std::vector<std::pair<std::string, double> > undo = applyState(newBlock);
+        newBlock.validateBlockPoS(leader);
+        std::map<std::string, Ed25519Key>::const_iterator key = signingKeys.find(newBlock.getValidator());
+        if(key != signingKeys.end()) {
+            newBlock.sign(key->second);
+        }
+        if(!appendBlock(std::move(newBlock))) {
+            state.applyBatch(undo);
+            return false;
+        }
+        return true;
+    }
+
+    // Index of the lowest invalid block, getSize() if the chain is valid.
+    // Only the blocks above the verified height and the last checkpoint
+    // matched are checked.
+    //
+    // The checks of a block need only the block and its predecessor, so
+    // the chain is cut into chunks of VALIDATION_CHUNK blocks handed out in
+    // order to the validation threads, and chunks above an invalid block
+    // already found are skipped. Retargeting is then replayed up to that
+    // block, and the signatures below it are checked in one batch, those
+    // verified by an earlier call coming from the verifier's cache. The
+    // answer is the same with any number of threads.
+    size_t findInvalidBlock() {
+        uint64_t trusted;
+        if(!checkpoints.trustedPrefix(chain.size(), [this](uint64_t h) -> const std::string& { return chain[h].getHash(); },
+                                      trusted)) {
+            return trusted;
+        }
+        size_t from = std::max<size_t>(verifiedHeight, trusted);
+        size_t workers = validationPool ? validationPool->size() : 1;
+        std::atomic<size_t> firstInvalid(chain.size());
+        std::atomic<size_t> nextChunk(from);
+        std::vector<std::vector<SignatureCheck> > signatures(workers);
+        std::vector<std::vector<size_t> > signedBlocks(workers);
+
+        auto validate = [&](size_t worker) {
+            // MerkleTreeComplete reuses a buffer, so each thread needs its own
+            MerkleTreeComplete local;
+            MerkleTreeComplete& tree = validationPool ? local : merkle;
+            for(;;) {
+                size_t first = nextChunk.fetch_add(VALIDATION_CHUNK);
+                if(first >= firstInvalid.load()) {
+                    return;
+                }
+                size_t last = chain.size() - first > VALIDATION_CHUNK ? first + VALIDATION_CHUNK : chain.size();
+                for(size_t i = first; i < last && i < firstInvalid.load(); i++) {
+                    size_t collected = signatures[worker].size();
+                    if(!isBlockValid(i, tree, signatures[worker])) {
+                        size_t seen = firstInvalid.load();
+                        while(i < seen && !firstInvalid.compare_exchange_weak(seen, i)) {}
+                        break;
+                    }
+                    if(signatures[worker].size() > collected) {
+                        signedBlocks[worker].push_back(i);
+                    }
+                }
             }
+        };
+        if(validationPool && chain.size() - from > VALIDATION_CHUNK) {
+            validationPool->run(workers, validate);
+        } else {
+            validate(0);
+        }
+        size_t invalid = firstInvalid.load();
 
-            if(currentBlock.getPreviousHash() != previousBlock.getHash()) {
-                return false;
+        if(retargeting) {
+            DifficultyRetargeter replay = retargeterAt(from);
+            for(size_t i = std::max<size_t>(retargetStart, from); i < invalid; i++) {
+                const BlockComplete& block = chain[i];
+                if(!isProofOfWork(block)) {
+                    continue;
+                }
+                if(block.getTarget() != replay.nextTarget()) {
+                    invalid = i;
+                    break;
+                }
+                replay.recordBlock((double)block.getTimestamp(), block.getTarget());
+            }
+        }
+
+        std::vector<SignatureCheck> batch;
+        std::vector<size_t> batchBlocks;
+        for(size_t w = 0; w < workers; w++) {
+            for(size_t k = 0; k < signedBlocks[w].size(); k++) {
+                if(signedBlocks[w][k] < invalid) {
+                    batch.push_back(signatures[w][k]);
+                    batchBlocks.push_back(signedBlocks[w][k]);
+                }
             }
+        }
+        std::vector<bool> results;
+        if(!verifier->verifyBatch(batch, &results)) {
+            for(size_t k = 0; k < batch.size(); k++) {
+                if(!results[k] && batchBlocks[k] < invalid) {
+                    invalid = batchBlocks[k];
+                }
+            }
+        }
+        if(invalid == chain.size()) {
+            verifiedHeight = invalid;
+        }
+        return invalid;
+    }
+
+    bool isChainValid() {
+        return findInvalidBlock() == chain.size();
+    }
+
+    // Blocks up to a checkpoint matched by the chain are not validated
+    void addCheckpoint(uint64_t height, const std::string& hash) { checkpoints.add(height, hash); }
+
+    // Returns false if the signature of authority does not verify
+    bool addSignedCheckpoint(uint64_t height, const std::string& hash, const Signature& signature,
+                             const PublicKey& authority) {
+        return checkpoints.addSigned(height, hash, signature, authority);
+    }
 
-            MerkleTreeComplete merkle;
-            if(currentBlock.getMerkleRoot() != merkle.getMerkleRoot(currentBlock.getTransactions())) {
+    // Blocks below it are known to be valid
+    size_t getVerifiedHeight() const { return verifiedHeight; }
+
+    // Makes the next isChainValid check the blocks from height on again;
+    // those up to a matched checkpoint stay trusted
+    void resetVerifiedHeight(size_t height = 1) {
+        verifiedHeight = std::min(verifiedHeight, std::max<size_t>(height, 1));
+    }
+
+    // Replays every block's transactions into a fresh state tree and checks
+    // the state root each block committed to
+    bool isStateValid() const {
+        SparseMerkleTree replay;
+        for(const auto& block : chain) {
+            replay.applyBatch(balanceUpdates(replay, block.getTransactions()));
+            if(!block.getStateRoot().empty() && block.getStateRoot() != replay.getRoot()) {
                 return false;
             }
         }
         return true;
     }
 
+    double getBalance(const std::string& address) const { return state.getBalance(address); }
+    std::string getStateRoot() const { return state.getRoot(); }
+
+    // Checked with SparseMerkleTree::verifyBalance / verifyAbsent against a block's state root
+    SparseMerkleTree::Proof getBalanceProof(const std::string& address) const {
+        return state.getProof(address);
+    }
+
+    // Proofs for light clients, checked against getBlock(blockIndex).getMerkleRoot().
+    // A block past the tip gives an empty proof, which never verifies.
+    MerkleProof getTransactionProof(size_t blockIndex, size_t txIndex) const {
+        if(blockIndex >= chain.size()) {
+            return MerkleProof();
+        }
+        MerkleTreeComplete tree;
+        return tree.getProof(chain[blockIndex].getTransactions(), txIndex);
+    }
+
+    // Transactions past the end of the block are left out of the proof
+    MerkleMultiProof getTransactionMultiProof(size_t blockIndex, const std::vector<size_t>& txIndices) const {
+        if(blockIndex >= chain.size()) {
+            return MerkleMultiProof();
+        }
+        MerkleTreeComplete tree;
+        return tree.getMultiProof(chain[blockIndex].getTransactions(), txIndices);
+    }
+
     size_t getSize() const { return chain.size(); }
-    BlockComplete getBlock(int index) const { return chain[index]; }
-    const std::vector<ValidatorComplete>& getValidators() const { return validators; }
+    // References stay valid until the next block is added
+    const BlockComplete& getBlock(int index) const { return chain[index]; }
+    const BlockHeader& getHeader(size_t index) const { return headers[index]; }
+    const std::vector<BlockHeader>& getHeaders() const { return headers; }
+    const std::vector<ValidatorComplete>& getValidators() const { return validators.getValidators(); }
 };
 
 
@@ -0,0 +1,243 @@
+//
+// Created by abdelaziz on 10/17/2026.
+//
+
+#ifndef IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_MINING_SERVICE_H
+#define IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_MINING_SERVICE_H
+
+#include <deque>
+#include <algorithm>
+#include <memory>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <chrono>
+#include "complete_blockchain.h"
+
+struct MinedBlock {
+    bool solved;
+    bool stale;             // abandoned because the chain tip moved
+    BlockComplete block;    // the template, with nonce and hash when solved
+    MiningResult result;
+
+    explicit MinedBlock(const BlockComplete& templateBlock)
+            : solved(false), stale(false), block(templateBlock) {}
+};
+
+struct MiningServiceStats {
+    uint64_t submitted;
+    uint64_t solved;
+    uint64_t staleDropped;      // stale before mining started
+    uint64_t staleAbandoned;    // cancelled while being mined
+    uint64_t hashes;
+    uint64_t staleHashes;       // spent on templates that went stale
+    double miningSeconds;
+    double staleSeconds;
+    double maxCancelMs;         // new tip -> miner stopped, worst case
+
+    MiningServiceStats()
+            : submitted(0), solved(0), staleDropped(0), staleAbandoned(0), hashes(0), staleHashes(0),
+              miningSeconds(0), staleSeconds(0), maxCancelMs(0) {}
+
+    double staleFraction() const {
+        return miningSeconds > 0 ? staleSeconds / miningSeconds : 0;
+    }
+};
+
+// Mines block templates in the background, one at a time in submission
+// order, so the node keeps accepting transactions and blocks meanwhile.
+// When the node moves to a new tip, templates built on the old one are
+// dropped from the queue and the one being mined is cancelled: the miner
+// checks the flag every ParallelMiner poll interval (256 nonces), so it
+// stops within that many hashes per thread.
+class MiningService {
+public:
+    // Called on the service thread
+    typedef std::function<void(const MinedBlock&)> Callback;
+
+private:
+    struct Job {
+        BlockComplete block;
+        DifficultyTarget target;
+        std::promise<MinedBlock> promise;
+        Callback callback;
+
+        Job(const BlockComplete& b, const DifficultyTarget& t, const Callback& c)
+                : block(b), target(t), callback(c) {}
+    };
+
+    ParallelMiner miner;
+    std::deque<std::shared_ptr<Job> > queue;
+    // Dropped by notifyNewTip, delivered by the service thread before it
+    // takes the next job
+    std::deque<std::shared_ptr<Job> > dropped;
+    std::shared_ptr<Job> current;
+    std::string tip;            // jobs must build on it; empty until the first notifyNewTip
+    std::atomic<bool> cancel;
+    bool currentStale;
+    std::chrono::steady_clock::time_point cancelRequested;
+    bool stopping;
+    MiningServiceStats stats;
+    std::mutex mutex;
+    std::condition_variable available;
+    std::thread worker;
+
+    static void deliver(Job& job, const MinedBlock& outcome) {
+        if(job.callback) {
+            job.callback(outcome);
+        }
+        job.promise.set_value(outcome);
+    }
+
+    static void deliverStale(Job& job) {
+        MinedBlock outcome(job.block);
+        outcome.stale = true;
+        deliver(job, outcome);
+    }
+
+    void run() {
+        while(true) {
+            std::shared_ptr<Job> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                available.wait(lock, [this] { return stopping || !queue.empty() || !dropped.empty(); });
+                if(!dropped.empty()) {
+                    std::deque<std::shared_ptr<Job> > stale;
+                    stale.swap(dropped);
+                    lock.unlock();
+                    for(auto& staleJob : stale) {
+                        deliverStale(*staleJob);
+                    }
+                    continue;
+                }
+                if(stopping) {
+                    break;
+                }
+                job = queue.front();
+                queue.pop_front();
+                if(!tip.empty() && job->block.getPreviousHash() != tip) {
+                    stats.staleDropped++;
+                    lock.unlock();
+                    deliverStale(*job);
+                    continue;
+                }
+                current = job;
+                currentStale = false;
+                cancel.store(false);
+            }
+
+            MinedBlock outcome(job->block);
+            outcome.result = outcome.block.mineBlockParallel(job->target, miner, &cancel);
+            outcome.solved = outcome.result.found;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                current.reset();
+                outcome.stale = currentStale;
+                stats.hashes += outcome.result.totalHashes();
+                stats.miningSeconds += outcome.result.seconds;
+                if(outcome.solved) {
+                    stats.solved++;
+                } else if(currentStale) {
+                    double ms = std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - cancelRequested).count();
+                    stats.staleAbandoned++;
+                    stats.staleHashes += outcome.result.totalHashes();
+                    stats.staleSeconds += outcome.result.seconds;
+                    stats.maxCancelMs = std::max(stats.maxCancelMs, ms);
+                }
+            }
+            deliver(*job, outcome);
+        }
+
+        // Stopped: whatever is left is never mined
+        std::deque<std::shared_ptr<Job> > left;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            left.swap(queue);
+        }
+        for(auto& job : left) {
+            deliver(*job, MinedBlock(job->block));
+        }
+    }
+
+public:
+    // threads = 0 uses one mining thread per hardware thread; nonceChunk
+    // is the range a thread takes at a time
+    explicit MiningService(unsigned threads = 0, uint64_t nonceChunk = 4096)
+            : miner(threads, nonceChunk), cancel(false), currentStale(false), stopping(false) {
+        worker = std::thread(&MiningService::run, this);
+    }
+
+    ~MiningService() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            cancel.store(true);
+        }
+        available.notify_all();
+        worker.join();
+    }
+
+    MiningService(const MiningService&) = delete;
+    MiningService& operator=(const MiningService&) = delete;
+
+    // Queues a template from CompleteBlockchain::createBlockTemplate. The
+    // future (and the callback, if any) gets the block once it is solved,
+    // stale or dropped at shutdown.
+    std::future<MinedBlock> submit(const BlockComplete& blockTemplate, const DifficultyTarget& target,
+                                   const Callback& callback = Callback()) {
+        std::shared_ptr<Job> job = std::make_shared<Job>(blockTemplate, target, callback);
+        std::future<MinedBlock> future = job->promise.get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stats.submitted++;
+            queue.push_back(job);
+        }
+        available.notify_one();
+        return future;
+    }
+
+    // The node's chain now ends with tipHash: every template built on
+    // another block is stale. Their futures and callbacks are completed on
+    // the service thread.
+    void notifyNewTip(const std::string& tipHash) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tip = tipHash;
+            std::deque<std::shared_ptr<Job> > kept;
+            for(auto& job : queue) {
+                if(job->block.getPreviousHash() == tip) {
+                    kept.push_back(job);
+                } else {
+                    dropped.push_back(job);
+                    stats.staleDropped++;
+                }
+            }
+            queue.swap(kept);
+
+            if(current && !currentStale && current->block.getPreviousHash() != tip) {
+                currentStale = true;
+                cancelRequested = std::chrono::steady_clock::now();
+                cancel.store(true);
+            }
+        }
+        available.notify_one();
+    }
+
+    size_t getPendingCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return queue.size() + (current ? 1 : 0);
+    }
+
+    MiningServiceStats getStats() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+
+    size_t getThreadCount() const { return miner.getThreadCount(); }
+};
+
+#endif //IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_MINING_SERVICE_H
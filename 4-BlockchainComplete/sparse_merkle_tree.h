@@ -0,0 +1,482 @@
+//
+// Created by abdelaziz on 10/17/2026.
+//
+
+#ifndef IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_SPARSE_MERKLE_TREE_H
+#define IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_SPARSE_MERKLE_TREE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <cstdint>
+#include <cstring>
+#include "../0-Common/digest.h"
+
+// Account balances committed in a sparse Merkle tree keyed by
+// SHA256(address). The path of an account is the bits of its key, most
+// significant first. A subtree holding a single account is stored as that
+// account's leaf, so the tree has about 2n nodes instead of 256n:
+//   empty subtree  -> 32 zero bytes
+//   leaf           -> SHA256(0x00 || key || balance as 8 big-endian bytes)
+//   internal node  -> SHA256(0x01 || left || right), only above 2+ accounts
+// A zero balance removes the account.
+class SparseMerkleTree {
+public:
+    enum ProofType {
+        PROOF_MEMBER,        // the account's own leaf ends the path
+        PROOF_EMPTY,         // the path ends on an empty subtree
+        PROOF_OTHER_LEAF     // the path ends on the leaf of another account
+    };
+
+    struct Proof {
+        ProofType type;
+        std::vector<Digest> siblings;   // from the root down
+        Digest leafKey;                 // key of the terminal leaf, if any
+        double leafBalance;
+
+        Proof() : type(PROOF_EMPTY), leafBalance(0) {}
+    };
+
+private:
+    // 0 = empty subtree, n > 0 = nodes[n - 1], n < 0 = leaves[-n - 1]
+    typedef int32_t Ref;
+
+    struct Node {
+        Digest hash;
+        Ref left;
+        Ref right;
+        bool persisted;
+    };
+
+    struct Leaf {
+        Digest key;
+        Digest hash;
+        double balance;
+        std::string address;
+        bool persisted;
+    };
+
+    struct Update {
+        Digest key;
+        double balance;
+        const std::string* address;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Leaf> leaves;
+    std::vector<Ref> freeNodes;
+    std::vector<Ref> freeLeaves;
+    std::unordered_map<std::string, Ref> leafByAddress;
+    Ref root;
+
+    static bool keyBit(const Digest& key, size_t depth) {
+        return (key[depth / 8] >> (7 - depth % 8)) & 1;
+    }
+
+    static Digest emptyHash() {
+        Digest zero;
+        zero.fill(0);
+        return zero;
+    }
+
+    static void encodeBalance(double balance, uint8_t* out) {
+        uint64_t bits;
+        std::memcpy(&bits, &balance, sizeof(bits));
+        for(int i = 0; i < 8; i++) {
+            out[i] = (uint8_t)(bits >> (56 - 8 * i));
+        }
+    }
+
+    static double decodeBalance(const uint8_t* in) {
+        uint64_t bits = 0;
+        for(int i = 0; i < 8; i++) {
+            bits = (bits << 8) | in[i];
+        }
+        double balance;
+        std::memcpy(&balance, &bits, sizeof(balance));
+        return balance;
+    }
+
+    static Digest nodeHash(const Digest& left, const Digest& right) {
+        uint8_t buffer[1 + 2 * SHA256_DIGEST_LENGTH];
+        buffer[0] = 0x01;
+        std::memcpy(buffer + 1, left.data(), SHA256_DIGEST_LENGTH);
+        std::memcpy(buffer + 1 + SHA256_DIGEST_LENGTH, right.data(), SHA256_DIGEST_LENGTH);
+        return sha256Digest(buffer, sizeof(buffer));
+    }
+
+    const Digest& refHash(Ref ref) const {
+        static const Digest EMPTY = emptyHash();
+        if(ref == 0) return EMPTY;
+        if(ref > 0) return nodes[ref - 1].hash;
+        return leaves[-ref - 1].hash;
+    }
+
+    Ref newLeaf(const Digest& key, double balance, const std::string& address) {
+        Ref ref;
+        if(!freeLeaves.empty()) {
+            ref = freeLeaves.back();
+            freeLeaves.pop_back();
+        } else {
+            leaves.push_back(Leaf());
+            ref = -(Ref)leaves.size();
+        }
+        Leaf& leaf = leaves[-ref - 1];
+        leaf.key = key;
+        leaf.balance = balance;
+        leaf.address = address;
+        leaf.hash = leafHash(key, balance);
+        leaf.persisted = false;
+        leafByAddress[address] = ref;
+        return ref;
+    }
+
+    void freeLeaf(Ref ref) {
+        Leaf& leaf = leaves[-ref - 1];
+        leafByAddress.erase(leaf.address);
+        leaf.address.clear();
+        freeLeaves.push_back(ref);
+    }
+
+    Ref newNode(Ref left, Ref right) {
+        Ref ref;
+        if(!freeNodes.empty()) {
+            ref = freeNodes.back();
+            freeNodes.pop_back();
+        } else {
+            nodes.push_back(Node());
+            ref = (Ref)nodes.size();
+        }
+        Node& node = nodes[ref - 1];
+        node.left = left;
+        node.right = right;
+        node.hash = nodeHash(refHash(left), refHash(right));
+        node.persisted = false;
+        return ref;
+    }
+
+    // Builds the subtree for a sorted run of leaves that all share the first depth bits
+    Ref buildSubtree(const std::vector<Ref>& run, size_t begin, size_t end, size_t depth) {
+        if(begin == end) return 0;
+        if(end - begin == 1) return run[begin];
+
+        size_t mid = begin;
+        while(mid < end && !keyBit(leaves[-run[mid] - 1].key, depth)) {
+            mid++;
+        }
+        Ref left = buildSubtree(run, begin, mid, depth + 1);
+        Ref right = buildSubtree(run, mid, end, depth + 1);
+        return newNode(left, right);
+    }
+
+    // Applies the sorted updates [begin, end), whose keys share the first
+    // depth bits, to the subtree ref. Untouched subtrees keep their cached hash.
+    Ref update(Ref ref, size_t depth, const Update* begin, const Update* end) {
+        if(begin == end) {
+            return ref;
+        }
+
+        if(ref > 0) {
+            const Update* mid = begin;
+            while(mid < end && !keyBit(mid->key, depth)) {
+                mid++;
+            }
+            Ref left = update(nodes[ref - 1].left, depth + 1, begin, mid);
+            Ref right = update(nodes[ref - 1].right, depth + 1, mid, end);
+
+            // A subtree left with zero or one account collapses to that account
+            if((left == 0 && right <= 0) || (right == 0 && left <= 0)) {
+                freeNodes.push_back(ref);
+                return left != 0 ? left : right;
+            }
+            Node& node = nodes[ref - 1];
+            node.left = left;
+            node.right = right;
+            node.hash = nodeHash(refHash(left), refHash(right));
+            node.persisted = false;
+            return ref;
+        }
+
+        // Empty subtree or single leaf: merge the existing leaf with the updates
+        std::vector<Ref> run;
+        bool existingKept = (ref < 0);
+        for(const Update* u = begin; u != end; u++) {
+            if(ref < 0 && u->key == leaves[-ref - 1].key) {
+                existingKept = false;
+                Leaf& leaf = leaves[-ref - 1];
+                if(u->balance != 0) {
+                    leaf.balance = u->balance;
+                    leaf.hash = leafHash(leaf.key, leaf.balance);
+                    leaf.persisted = false;
+                    run.push_back(ref);
+                } else {
+                    freeLeaf(ref);
+                }
+            } else if(u->balance != 0) {
+                run.push_back(newLeaf(u->key, u->balance, *u->address));
+            }
+        }
+        if(existingKept) {
+            run.push_back(ref);
+        }
+
+        std::sort(run.begin(), run.end(), [this](Ref x, Ref y) {
+            return leaves[-x - 1].key < leaves[-y - 1].key;
+        });
+        return buildSubtree(run, 0, run.size(), depth);
+    }
+
+    // Writes the records of every node changed since the last save; a
+    // persisted node means its whole subtree is already on disk
+    void saveSubtree(Ref ref, std::ostream& out) {
+        if(ref == 0) {
+            return;
+        }
+        if(ref < 0) {
+            Leaf& leaf = leaves[-ref - 1];
+            if(leaf.persisted) return;
+            uint8_t record[1 + SHA256_DIGEST_LENGTH + 8 + 4];
+            record[0] = 'L';
+            std::memcpy(record + 1, leaf.key.data(), SHA256_DIGEST_LENGTH);
+            encodeBalance(leaf.balance, record + 1 + SHA256_DIGEST_LENGTH);
+            uint32_t length = (uint32_t)leaf.address.size();
+            for(int i = 0; i < 4; i++) {
+                record[1 + SHA256_DIGEST_LENGTH + 8 + i] = (uint8_t)(length >> (24 - 8 * i));
+            }
+            out.write((const char*)record, sizeof(record));
+            out.write(leaf.address.data(), leaf.address.size());
+            leaf.persisted = true;
+            return;
+        }
+
+        Node& node = nodes[ref - 1];
+        if(node.persisted) return;
+        saveSubtree(node.left, out);
+        saveSubtree(node.right, out);
+        out.put('N');
+        out.write((const char*)refHash(node.left).data(), SHA256_DIGEST_LENGTH);
+        out.write((const char*)refHash(node.right).data(), SHA256_DIGEST_LENGTH);
+        node.persisted = true;
+    }
+
+    struct StoredRecord {
+        bool isLeaf;
+        Digest left;
+        Digest right;
+        Digest key;
+        double balance;
+        std::string address;
+    };
+
+    Ref loadSubtree(const Digest& hash, const std::map<Digest, StoredRecord>& records, bool& ok) {
+        if(hash == emptyHash()) {
+            return 0;
+        }
+        std::map<Digest, StoredRecord>::const_iterator it = records.find(hash);
+        if(it == records.end()) {
+            ok = false;
+            return 0;
+        }
+        const StoredRecord& record = it->second;
+        if(record.isLeaf) {
+            Ref ref = newLeaf(record.key, record.balance, record.address);
+            leaves[-ref - 1].persisted = true;
+            return ref;
+        }
+        Ref left = loadSubtree(record.left, records, ok);
+        Ref right = loadSubtree(record.right, records, ok);
+        Ref ref = newNode(left, right);
+        nodes[ref - 1].persisted = true;
+        return ref;
+    }
+
+public:
+    SparseMerkleTree() : root(0) {}
+
+    static Digest accountKey(const std::string& address) {
+        return sha256Digest(address);
+    }
+
+    static Digest leafHash(const Digest& key, double balance) {
+        uint8_t buffer[1 + SHA256_DIGEST_LENGTH + 8];
+        buffer[0] = 0x00;
+        std::memcpy(buffer + 1, key.data(), SHA256_DIGEST_LENGTH);
+        encodeBalance(balance, buffer + 1 + SHA256_DIGEST_LENGTH);
+        return sha256Digest(buffer, sizeof(buffer));
+    }
+
+    // Sets the balance of every listed account in one pass over the tree;
+    // a zero balance removes the account. With duplicates the last one wins.
+    void applyBatch(const std::vector<std::pair<std::string, double> >& balances) {
+        std::vector<Update> updates;
+        updates.reserve(balances.size());
+        for(const auto& entry : balances) {
+            Update u;
+            u.key = accountKey(entry.first);
+            u.balance = (entry.second == 0) ? 0.0 : entry.second;
+            u.address = &entry.first;
+            updates.push_back(u);
+        }
+        std::stable_sort(updates.begin(), updates.end(), [](const Update& x, const Update& y) {
+            return x.key < y.key;
+        });
+
+        std::vector<Update> unique;
+        unique.reserve(updates.size());
+        for(size_t i = 0; i < updates.size(); i++) {
+            if(i + 1 < updates.size() && updates[i + 1].key == updates[i].key) {
+                continue;
+            }
+            unique.push_back(updates[i]);
+        }
+
+        if(!unique.empty()) {
+            root = update(root, 0, &unique[0], &unique[0] + unique.size());
+        }
+    }
+
+    void setBalance(const std::string& address, double balance) {
+        applyBatch(std::vector<std::pair<std::string, double> >(1, std::make_pair(address, balance)));
+    }
+
+    double getBalance(const std::string& address) const {
+        std::unordered_map<std::string, Ref>::const_iterator it = leafByAddress.find(address);
+        return it == leafByAddress.end() ? 0.0 : leaves[-it->second - 1].balance;
+    }
+
+    Digest getRootDigest() const { return refHash(root); }
+    std::string getRoot() const { return digestToHex(refHash(root)); }
+    size_t getAccountCount() const { return leafByAddress.size(); }
+
+    // Calls visit(address, balance) for every account
+    template <typename Visitor>
+    void forEachAccount(Visitor visit) const {
+        for(const auto& entry : leafByAddress) {
+            visit(entry.first, leaves[-entry.second - 1].balance);
+        }
+    }
+
+    Proof getProof(const std::string& address) const {
+        Digest key = accountKey(address);
+        Proof proof;
+        Ref ref = root;
+        size_t depth = 0;
+        while(ref > 0) {
+            const Node& node = nodes[ref - 1];
+            bool right = keyBit(key, depth);
+            proof.siblings.push_back(refHash(right ? node.left : node.right));
+            ref = right ? node.right : node.left;
+            depth++;
+        }
+
+        if(ref < 0) {
+            const Leaf& leaf = leaves[-ref - 1];
+            proof.type = (leaf.key == key) ? PROOF_MEMBER : PROOF_OTHER_LEAF;
+            proof.leafKey = leaf.key;
+            proof.leafBalance = leaf.balance;
+        } else {
+            proof.type = PROOF_EMPTY;
+        }
+        return proof;
+    }
+
+    // Recomputes the root from the terminal node of the proof up along key's path
+    static bool proofMatchesRoot(const Digest& key, const Proof& proof, const Digest& root) {
+        if(proof.siblings.size() > 8 * SHA256_DIGEST_LENGTH) {
+            return false;
+        }
+        Digest node = (proof.type == PROOF_EMPTY) ? emptyHash() : leafHash(proof.leafKey, proof.leafBalance);
+        for(size_t depth = proof.siblings.size(); depth-- > 0;) {
+            node = keyBit(key, depth) ? nodeHash(proof.siblings[depth], node)
+                                      : nodeHash(node, proof.siblings[depth]);
+        }
+        return node == root;
+    }
+
+    static bool verifyBalance(const Digest& root, const std::string& address,
+                              double balance, const Proof& proof) {
+        Digest key = accountKey(address);
+        return proof.type == PROOF_MEMBER && proof.leafKey == key &&
+               proof.leafBalance == balance && balance != 0 &&
+               proofMatchesRoot(key, proof, root);
+    }
+
+    // The account is absent if its path ends on an empty subtree, or on the
+    // leaf of another account sitting where this account would be
+    static bool verifyAbsent(const Digest& root, const std::string& address, const Proof& proof) {
+        Digest key = accountKey(address);
+        if(proof.type == PROOF_MEMBER) {
+            return false;
+        }
+        if(proof.type == PROOF_OTHER_LEAF) {
+            if(proof.leafKey == key) {
+                return false;
+            }
+            for(size_t depth = 0; depth < proof.siblings.size(); depth++) {
+                if(keyBit(proof.leafKey, depth) != keyBit(key, depth)) {
+                    return false;
+                }
+            }
+        }
+        return proofMatchesRoot(key, proof, root);
+    }
+
+    // Appends the nodes changed since the previous save, then the current
+    // root. Unchanged subtrees are never written twice, so saving after each
+    // block costs O(changed accounts * depth).
+    void save(std::ostream& out) {
+        saveSubtree(root, out);
+        out.put('R');
+        out.write((const char*)refHash(root).data(), SHA256_DIGEST_LENGTH);
+    }
+
+    // Rebuilds the tree from the last root found in a file written by save()
+    bool load(std::istream& in) {
+        std::map<Digest, StoredRecord> records;
+        Digest lastRoot = emptyHash();
+        char tag;
+        while(in.get(tag)) {
+            StoredRecord record;
+            if(tag == 'L') {
+                uint8_t fixed[SHA256_DIGEST_LENGTH + 8 + 4];
+                if(!in.read((char*)fixed, sizeof(fixed))) return false;
+                record.isLeaf = true;
+                std::memcpy(record.key.data(), fixed, SHA256_DIGEST_LENGTH);
+                record.balance = decodeBalance(fixed + SHA256_DIGEST_LENGTH);
+                uint32_t length = 0;
+                for(int i = 0; i < 4; i++) {
+                    length = (length << 8) | fixed[SHA256_DIGEST_LENGTH + 8 + i];
+                }
+                record.address.resize(length);
+                if(length > 0 && !in.read(&record.address[0], length)) return false;
+                records[leafHash(record.key, record.balance)] = record;
+            } else if(tag == 'N') {
+                record.isLeaf = false;
+                if(!in.read((char*)record.left.data(), SHA256_DIGEST_LENGTH)) return false;
+                if(!in.read((char*)record.right.data(), SHA256_DIGEST_LENGTH)) return false;
+                records[nodeHash(record.left, record.right)] = record;
+            } else if(tag == 'R') {
+                if(!in.read((char*)lastRoot.data(), SHA256_DIGEST_LENGTH)) return false;
+            } else {
+                return false;
+            }
+        }
+
+        nodes.clear();
+        leaves.clear();
+        freeNodes.clear();
+        freeLeaves.clear();
+        leafByAddress.clear();
+        bool ok = true;
+        root = loadSubtree(lastRoot, records, ok);
+        return ok && refHash(root) == lastRoot;
+    }
+};
+
+
+#endif //IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_SPARSE_MERKLE_TREE_H
@@ -0,0 +1,239 @@
+//
+// Created by abdelaziz on 10/17/2026.
+//
+
+#ifndef IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_STATE_SNAPSHOT_H
+#define IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_STATE_SNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include "../0-Common/digest.h"
+#include "../3-ProofofStake/validator_registry.h"
+#include "block_header.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+// State derived from the blocks up to height: account balances,
+// validators and pending unbondings, with the hash of block height. A node
+// restarts from it and replays only the blocks after.
+//
+// File, integers big-endian, strings as a 4-byte length then their bytes:
+//
+//   magic "SNAP" 4, format 4
+//   height 8, tip hash 32, state root 32
+//   accounts 8, then address, balance (the 8 bytes of the double)
+//   validators 8, then address, stake 8, unbonding 8, slashed 8, key 32
+//   unbondings 8, then address, amount 8, release epoch 8
+//   SHA256 of everything before, 32
+//
+// save() writes a temporary file then renames it over the previous
+// snapshot, so a crash leaves either the old or the new one. The checksum
+// only detects damage: nothing in a snapshot is trusted as validated.
+struct StateSnapshot {
+    // 1 also held the verified height
+    static const uint32_t FORMAT = 2;
+
+    uint64_t height;
+    Digest tipHash;
+    Digest stateRoot;
+    // Sorted by address
+    std::vector<std::pair<std::string, double> > balances;
+    std::vector<ValidatorRecord> validators;
+    std::vector<Unbonding> unbondings;
+
+    StateSnapshot() : height(0) {
+        tipHash.fill(0);
+        stateRoot.fill(0);
+    }
+
+    static std::string path(const std::string& directory) {
+        return directory + "/state.snapshot";
+    }
+
+    static void remove(const std::string& directory) {
+        std::remove(path(directory).c_str());
+    }
+
+    void encode(std::vector<uint8_t>& out) const {
+        out.insert(out.end(), {'S', 'N', 'A', 'P'});
+        putUint(out, FORMAT, 4);
+        putUint(out, height, 8);
+        out.insert(out.end(), tipHash.begin(), tipHash.end());
+        out.insert(out.end(), stateRoot.begin(), stateRoot.end());
+        putUint(out, balances.size(), 8);
+        for(const auto& account : balances) {
+            putString(out, account.first);
+            uint64_t bits;
+            std::memcpy(&bits, &account.second, sizeof(bits));
+            putUint(out, bits, 8);
+        }
+        putUint(out, validators.size(), 8);
+        for(const auto& record : validators) {
+            putString(out, record.address);
+            putUint(out, record.stake, 8);
+            putUint(out, record.unbonding, 8);
+            putUint(out, record.slashed, 8);
+            out.insert(out.end(), record.publicKey.begin(), record.publicKey.end());
+        }
+        putUint(out, unbondings.size(), 8);
+        for(const auto& entry : unbondings) {
+            putString(out, entry.address);
+            putUint(out, entry.amount, 8);
+            putUint(out, entry.releaseEpoch, 8);
+        }
+        Digest checksum = sha256Digest(out.data(), out.size());
+        out.insert(out.end(), checksum.begin(), checksum.end());
+    }
+
+    // Returns false if the bytes are not exactly one snapshot with a good checksum
+    static bool decode(const uint8_t* data, size_t size, StateSnapshot& out) {
+        if(size < 8 + SHA256_DIGEST_LENGTH || std::memcmp(data, "SNAP", 4) != 0
+           || sha256Digest(data, size - SHA256_DIGEST_LENGTH)
+              != toDigest(data + size - SHA256_DIGEST_LENGTH)) {
+            return false;
+        }
+        Reader in;
+        in.position = data + 4;
+        in.end = data + size - SHA256_DIGEST_LENGTH;
+        uint64_t format, count;
+        if(!in.getUint(4, format) || format != FORMAT || !in.getUint(8, out.height)
+           || !in.getDigest(out.tipHash) || !in.getDigest(out.stateRoot)) {
+            return false;
+        }
+
+        out.balances.clear();
+        if(!in.getUint(8, count)) {
+            return false;
+        }
+        for(uint64_t i = 0; i < count; i++) {
+            std::string address;
+            uint64_t bits;
+            if(!in.getString(address) || !in.getUint(8, bits)) {
+                return false;
+            }
+            double balance;
+            std::memcpy(&balance, &bits, sizeof(balance));
+            out.balances.push_back(std::make_pair(address, balance));
+        }
+
+        out.validators.clear();
+        if(!in.getUint(8, count)) {
+            return false;
+        }
+        for(uint64_t i = 0; i < count; i++) {
+            ValidatorRecord record("", 0);
+            if(!in.getString(record.address) || !in.getUint(8, record.stake) || !in.getUint(8, record.unbonding)
+               || !in.getUint(8, record.slashed) || !in.getDigest(record.publicKey)) {
+                return false;
+            }
+            out.validators.push_back(record);
+        }
+
+        out.unbondings.clear();
+        if(!in.getUint(8, count)) {
+            return false;
+        }
+        for(uint64_t i = 0; i < count; i++) {
+            Unbonding entry;
+            if(!in.getString(entry.address) || !in.getUint(8, entry.amount) || !in.getUint(8, entry.releaseEpoch)) {
+                return false;
+            }
+            out.unbondings.push_back(entry);
+        }
+        return in.position == in.end;
+    }
+
+    bool save(const std::string& directory) const {
+        std::vector<uint8_t> bytes;
+        encode(bytes);
+        std::string target = path(directory);
+        std::string temporary = target + ".tmp";
+        std::FILE* file = std::fopen(temporary.c_str(), "wb");
+        if(file == nullptr) {
+            return false;
+        }
+        bool written = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size() && std::fflush(file) == 0;
+#ifndef _WIN32
+        written = written && fsync(fileno(file)) == 0;
+#endif
+        std::fclose(file);
+        if(!written) {
+            std::remove(temporary.c_str());
+            return false;
+        }
+#ifdef _WIN32
+        std::remove(target.c_str());
+#endif
+        return std::rename(temporary.c_str(), target.c_str()) == 0;
+    }
+
+    // Returns false if there is no snapshot in directory or it is damaged
+    static bool load(const std::string& directory, StateSnapshot& out) {
+        std::ifstream in(path(directory).c_str(), std::ios::binary);
+        if(!in) {
+            return false;
+        }
+        std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        return decode(bytes.data(), bytes.size(), out);
+    }
+
+private:
+    static void putUint(std::vector<uint8_t>& out, uint64_t value, size_t bytes) {
+        out.resize(out.size() + bytes);
+        BlockHeader::writeUint(&out[out.size() - bytes], value, bytes);
+    }
+
+    static void putString(std::vector<uint8_t>& out, const std::string& text) {
+        putUint(out, text.size(), 4);
+        out.insert(out.end(), text.begin(), text.end());
+    }
+
+    static Digest toDigest(const uint8_t* bytes) {
+        Digest digest;
+        std::memcpy(digest.data(), bytes, digest.size());
+        return digest;
+    }
+
+    // Bounds-checked cursor over an encoded snapshot
+    struct Reader {
+        const uint8_t* position;
+        const uint8_t* end;
+
+        bool getUint(size_t bytes, uint64_t& value) {
+            if((size_t)(end - position) < bytes) {
+                return false;
+            }
+            value = BlockHeader::readUint(position, bytes);
+            position += bytes;
+            return true;
+        }
+
+        bool getDigest(Digest& digest) {
+            if((size_t)(end - position) < digest.size()) {
+                return false;
+            }
+            digest = toDigest(position);
+            position += digest.size();
+            return true;
+        }
+
+        bool getString(std::string& text) {
+            uint64_t length;
+            if(!getUint(4, length) || (uint64_t)(end - position) < length) {
+                return false;
+            }
+            text.assign((const char*)position, length);
+            position += length;
+            return true;
+        }
+    };
+};
+
+#endif //IMPLEMENTATION_DE_BLOCKCHAIN_EN_CPP_STATE_SNAPSHOT_H
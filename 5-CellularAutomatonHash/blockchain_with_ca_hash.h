@@ -12,6 +12,14 @@
 #include <vector>
 #include <ctime>
 #include <cstdlib>
+#include <memory>
+#include <algorithm>
+#include "../0-Common/difficulty_target.h"
+#include "../0-Common/checkpoints.h"
+#include "../2-ProofofWork/parallel_miner.h"
+#include "../2-ProofofWork/nonce_search.h"
+#include "../2-ProofofWork/difficulty_retarget.h"
+#include "../3-ProofofStake/leader_election.h"
 
 // Transaction structure
 struct Transaction {
@@ -39,6 +47,17 @@ enum HashMode {
     AC_HASH_MODE
 };
 
+// Version 1 hashes index, timestamp, previous hash, Merkle root, nonce and
+// transactions; version 2 also hashes the validator, so a PoS block cannot
+// be turned into a PoW one or credited to another validator, and version 3
+// the target, so the work a block claims cannot be changed after mining.
+// Version 3 puts the nonce last: an AC_HASH cell only depends on the input
+// bits within caSteps of it, so a nonce followed by the 64 hex digits of
+// the target would no longer reach the first digits of the hash.
+const uint32_t CA_BLOCK_VERSION_LEGACY = 1;
+const uint32_t CA_BLOCK_VERSION_VALIDATOR = 2;
+const uint32_t CA_BLOCK_VERSION_TARGET = 3;
+
 // Block class with configurable hash function
 class BlockWithCA {
 private:
@@ -47,24 +66,50 @@ private:
     std::string previousHash;
     std::string merkleRoot;
     std::string hash;
-    int nonce;
+    uint64_t nonce;
     std::vector<Transaction> transactions;
     std::string validator;
+    uint32_t version;
 
     HashMode hashMode;
     uint32_t caRule;
     size_t caSteps;
+    // Target the block was mined for
+    DifficultyTarget target;
+
+    // The preimage is prefix + decimal nonce + suffix
+    void preimageParts(std::string& prefix, std::string& suffix) const {
+        std::stringstream head;
+        head << index << timestamp << previousHash << merkleRoot;
+        std::stringstream tail;
+        std::stringstream& body = version >= CA_BLOCK_VERSION_TARGET ? head : tail;
+        for(const auto& tx : transactions) {
+            body << tx.id << tx.sender << tx.receiver << tx.amount;
+        }
+        if (version >= CA_BLOCK_VERSION_VALIDATOR) {
+            body << validator;
+        }
+        if (version >= CA_BLOCK_VERSION_TARGET) {
+            body << target.toHex();
+        }
+        prefix = head.str();
+        suffix = tail.str();
+    }
 
-    // SHA256 hash
-    std::string sha256Hash(const std::string& data) {
-        unsigned char hashArray[SHA256_DIGEST_LENGTH];
-        SHA256((unsigned char*)data.c_str(), data.length(), hashArray);
-
-        std::stringstream ss;
-        for(int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
-            ss << std::hex << std::setw(2) << std::setfill('0') << (int)hashArray[i];
+    // AC_HASH only gives hex, which the target parses back
+    bool findAcNonceInRange(uint64_t first, uint64_t last, const DifficultyTarget& blockTarget,
+                            uint64_t& found, std::string& foundHash, uint64_t& hashes) const {
+        hashes = 0;
+        for(uint64_t n = first; n <= last; n++) {
+            std::string candidate = computeHash(n);
+            hashes++;
+            if(blockTarget.isMetByHex(candidate)) {
+                found = n;
+                foundHash = candidate;
+                return true;
+            }
         }
-        return ss.str();
+        return false;
     }
 
 public:
@@ -72,55 +117,113 @@ public:
                 const std::vector<Transaction>& txs,
                 HashMode mode = SHA256_MODE,
                 uint32_t rule = 30,
-                size_t steps = 128)
+                size_t steps = 128,
+                uint32_t blockVersion = CA_BLOCK_VERSION_TARGET)
             : index(idx), previousHash(prevHash), nonce(0),
-              transactions(txs), validator(""),
+              transactions(txs), validator(""), version(blockVersion),
               hashMode(mode), caRule(rule), caSteps(steps) {
         timestamp = time(nullptr);
         merkleRoot = "merkle_root_placeholder";
         calculateHash();
     }
 
+    // Hash of the block as if its nonce were n; safe to call from several threads
+    std::string computeHash(uint64_t n) const {
+        std::string prefix, suffix;
+        preimageParts(prefix, suffix);
+        std::string data = prefix + std::to_string(n) + suffix;
+
+        if (hashMode == AC_HASH_MODE) {
+            return ac_hash(data, caRule, caSteps);
+        }
+        return digestToHex(sha256Digest(data));
+    }
+
     // Calculate hash based on selected mode
     void calculateHash() {
-        std::stringstream ss;
-        ss << index << timestamp << previousHash << merkleRoot << nonce;
+        hash = computeHash(nonce);
+    }
 
-        for(const auto& tx : transactions) {
-            ss << tx.id << tx.sender << tx.receiver << tx.amount;
+    // Mine block with selected hash function. In SHA256 mode candidates are
+    // hashed in batches from the prefix midstate and compared as raw
+    // digests; only the solution is formatted to hex.
+    void mineBlock(const DifficultyTarget& blockTarget) {
+        target = blockTarget;
+        if (hashMode == SHA256_MODE) {
+            std::string prefix, suffix;
+            preimageParts(prefix, suffix);
+            uint64_t found = 0;
+            if (findNonceBatched(prefix, suffix, nonce, target, found, hash)) {
+                nonce = found;
+            }
+            return;
         }
+        do {
+            nonce++;
+            calculateHash();
+        } while (!target.isMetByHex(hash));
+    }
 
-        std::string data = ss.str();
+    // difficulty = number of leading '0' in the hex hash
+    void mineBlock(int difficulty) {
+        mineBlock(DifficultyTarget::fromHexZeros(difficulty));
+    }
 
-        if (hashMode == AC_HASH_MODE) {
-            hash = ac_hash(data, caRule, caSteps);
+    // Same result as mineBlock, searched by all the miner's threads.
+    // Leaves the block unchanged if cancel is raised before a solution is found.
+    MiningResult mineBlockParallel(const DifficultyTarget& blockTarget, ParallelMiner& miner,
+                                   const std::atomic<bool>* cancel = nullptr) {
+        // Hashed from version 3 on, so set while the workers search
+        DifficultyTarget previousTarget = target;
+        target = blockTarget;
+        std::string prefix, suffix;
+        preimageParts(prefix, suffix);
+        MiningResult result = miner.mine(
+                [&](uint64_t first, uint64_t last, uint64_t& found, std::string& foundHash, uint64_t& hashes) {
+                    if (hashMode == SHA256_MODE) {
+                        return findNonceInRange(prefix, suffix, first, last, blockTarget, found, foundHash, hashes);
+                    }
+                    return findAcNonceInRange(first, last, blockTarget, found, foundHash, hashes);
+                },
+                nonce + 1, UINT64_MAX, cancel);
+
+        if(result.found) {
+            nonce = result.nonce;
+            hash = result.hash;
         } else {
-            hash = sha256Hash(data);
+            target = previousTarget;
         }
+        return result;
     }
 
-    // Mine block with selected hash function
-    void mineBlock(int difficulty) {
-        std::string target(difficulty, '0');
-
-        do {
-            nonce++;
-            calculateHash();
-        } while (hash.substr(0, difficulty) != target);
+    MiningResult mineBlockParallel(int difficulty, ParallelMiner& miner,
+                                   const std::atomic<bool>* cancel = nullptr) {
+        return mineBlockParallel(DifficultyTarget::fromHexZeros(difficulty), miner, cancel);
     }
 
     // Getters
     int getIndex() const { return index; }
-    std::string getHash() const { return hash; }
-    std::string getPreviousHash() const { return previousHash; }
-    int getNonce() const { return nonce; }
-    std::string getValidator() const { return validator; }
+    time_t getTimestamp() const { return timestamp; }
+    const std::string& getHash() const { return hash; }
+    const std::string& getPreviousHash() const { return previousHash; }
+    uint64_t getNonce() const { return nonce; }
+    const std::string& getValidator() const { return validator; }
+    uint32_t getVersion() const { return version; }
+    // PoS blocks name their validator and do not take part in retargeting
+    bool isProofOfStake() const { return !validator.empty(); }
     HashMode getHashMode() const { return hashMode; }
     uint32_t getCaRule() const { return caRule; }
     size_t getCaSteps() const { return caSteps; }
+    const DifficultyTarget& getTarget() const { return target; }
+    bool meetsTarget() const { return target.isMetByHex(hash); }
 
     // Setters
-    void setValidator(const std::string& v) { validator = v; }
+    // Does not rehash: from version 3 on, a changed target breaks the hash
+    void setTarget(const DifficultyTarget& t) { target = t; }
+    void setValidator(const std::string& v) {
+        validator = v;
+        calculateHash();
+    }
     void setCaRule(uint32_t rule) {
         caRule = rule;
         calculateHash();
@@ -138,115 +241,240 @@ private:
     HashMode defaultHashMode;
     uint32_t defaultCaRule;
     size_t defaultCaSteps;
+    uint32_t blockVersion;
     std::vector<Validator> validators;
+    // cumulativeStakes[i] = stakes of validators 0..i; validators are only
+    // appended, so the first count entries are the sums as of any block
+    std::vector<double> cumulativeStakes;
+    // Validators are only appended: validatorCounts[i] of them existed when block i was added
+    std::vector<size_t> validatorCounts;
+    std::shared_ptr<ParallelMiner> miner;
+    MiningResult lastMining;
+    // PoW targets from chain[retargetStart] on come from the retargeter
+    bool retargeting;
+    size_t retargetStart;
+    DifficultyRetargeter retargeter;
+    // Blocks below it passed isChainValid; blocks are never modified
+    size_t verifiedHeight;
+    Checkpoints checkpoints;
 
     BlockWithCA createGenesisBlock() {
         std::vector<Transaction> emptyTxs;
-        return BlockWithCA(0, "0", emptyTxs, defaultHashMode, defaultCaRule, defaultCaSteps);
+        return BlockWithCA(0, "0", emptyTxs, defaultHashMode, defaultCaRule, defaultCaSteps, blockVersion);
+    }
+
+    // The retargeter as it stood when block height was added; only the
+    // last window PoW blocks before it matter
+    DifficultyRetargeter retargeterAt(size_t height) const {
+        const RetargetParams& params = retargeter.getParams();
+        DifficultyRetargeter replay(params);
+        std::vector<size_t> recent;
+        size_t first = std::max<size_t>(retargetStart, 1);
+        for (size_t i = height; i > first && recent.size() < params.window; i--) {
+            if (!chain[i - 1].isProofOfStake()) {
+                recent.push_back(i - 1);
+            }
+        }
+        for (std::vector<size_t>::reverse_iterator it = recent.rbegin(); it != recent.rend(); ++it) {
+            replay.recordBlock((double)chain[*it].getTimestamp(), chain[*it].getTarget());
+        }
+        return replay;
+    }
+
+    void appendBlock(BlockWithCA block) {
+        chain.push_back(std::move(block));
+        validatorCounts.push_back(validators.size());
+    }
+
+    // Leader among the first count validators, O(log count); stakes are
+    // doubles, so the ticket is the seed as a fraction of the total stake
+    std::string electValidator(const std::string& previousHash, uint64_t slot, size_t count) const {
+        if (count == 0 || cumulativeStakes[count - 1] <= 0) {
+            return "";
+        }
+        double ticket = leaderFraction(leaderSeed(previousHash, slot)) * cumulativeStakes[count - 1];
+        size_t index = std::upper_bound(cumulativeStakes.begin(), cumulativeStakes.begin() + count, ticket)
+                       - cumulativeStakes.begin();
+        return validators[std::min(index, count - 1)].address;
     }
 
 public:
     BlockchainWithCA(HashMode mode = SHA256_MODE, uint32_t rule = 30, size_t steps = 128)
-            : defaultHashMode(mode), defaultCaRule(rule), defaultCaSteps(steps) {
-        chain.push_back(createGenesisBlock());
-        srand(time(nullptr));
+            : defaultHashMode(mode), defaultCaRule(rule), defaultCaSteps(steps),
+              blockVersion(CA_BLOCK_VERSION_TARGET), retargeting(false), retargetStart(0), verifiedHeight(1) {
+        appendBlock(createGenesisBlock());
     }
 
-    // Add block with Proof of Work
-    void addBlockPoW(const std::vector<Transaction>& transactions, int difficulty) {
+    // Add block with Proof of Work; once retargeting is enabled the target
+    // argument is ignored and getNextTarget() is used
+    void addBlockPoW(const std::vector<Transaction>& transactions, const DifficultyTarget& target) {
         BlockWithCA newBlock(chain.size(),
                              chain.back().getHash(),
                              transactions,
                              defaultHashMode,
                              defaultCaRule,
-                             defaultCaSteps);
-        newBlock.mineBlock(difficulty);
-        chain.push_back(newBlock);
+                             defaultCaSteps,
+                             blockVersion);
+        DifficultyTarget blockTarget = retargeting ? retargeter.nextTarget() : target;
+        if (miner) {
+            lastMining = newBlock.mineBlockParallel(blockTarget, *miner);
+        } else {
+            newBlock.mineBlock(blockTarget);
+        }
+        if (retargeting) {
+            retargeter.recordBlock((double)newBlock.getTimestamp(), blockTarget);
+        }
+        appendBlock(std::move(newBlock));
+    }
+
+    void addBlockPoW(const std::vector<Transaction>& transactions) {
+        addBlockPoW(transactions, getNextTarget());
+    }
+
+    // From the next block on, PoW targets follow the observed block times
+    void enableRetargeting(const RetargetParams& params) {
+        retargeting = true;
+        retargetStart = chain.size();
+        retargeter = DifficultyRetargeter(params);
+    }
+
+    DifficultyTarget getNextTarget() const { return retargeter.nextTarget(); }
+
+    void addBlockPoW(const std::vector<Transaction>& transactions, int difficulty) {
+        addBlockPoW(transactions, DifficultyTarget::fromHexZeros(difficulty));
     }
 
     // Add block with Proof of Stake
     void addBlockPoS(const std::vector<Transaction>& transactions) {
-        if (validators.empty()) {
+        std::string leader = selectValidator(chain.back().getHash(), chain.size());
+        if (leader.empty()) {
             std::cout << "No validators registered!" << std::endl;
             return;
         }
 
-        std::string selectedValidator = selectValidator();
-
         BlockWithCA newBlock(chain.size(),
                              chain.back().getHash(),
                              transactions,
                              defaultHashMode,
                              defaultCaRule,
-                             defaultCaSteps);
-        newBlock.setValidator(selectedValidator);
-        chain.push_back(newBlock);
+                             defaultCaSteps,
+                             blockVersion);
+        newBlock.setValidator(leader);
+        appendBlock(std::move(newBlock));
     }
 
-    // Validate chain
+    // Validate the blocks above the verified height and the last checkpoint
     bool isChainValid() {
-        for (size_t i = 1; i < chain.size(); i++) {
-            BlockWithCA currentBlock = chain[i];
-            BlockWithCA previousBlock = chain[i - 1];
+        uint64_t trusted;
+        if (!checkpoints.trustedPrefix(chain.size(), [this](uint64_t h) -> const std::string& { return chain[h].getHash(); },
+                                       trusted)) {
+            return false;
+        }
+        size_t from = std::max<size_t>(verifiedHeight, trusted);
+        DifficultyRetargeter replay = retargeterAt(from);
+        for (size_t i = from; i < chain.size(); i++) {
+            const BlockWithCA& currentBlock = chain[i];
+            const BlockWithCA& previousBlock = chain[i - 1];
 
             // Recalculate hash to verify
-            std::string originalHash = currentBlock.getHash();
-            BlockWithCA tempBlock = currentBlock;
-            tempBlock.calculateHash();
+            if (currentBlock.getHash() != currentBlock.computeHash(currentBlock.getNonce())) {
+                return false;
+            }
 
-            if (originalHash != tempBlock.getHash()) {
+            if (!currentBlock.meetsTarget()) {
                 return false;
             }
 
+            if (retargeting && i >= retargetStart && !currentBlock.isProofOfStake()) {
+                if (currentBlock.getTarget() != replay.nextTarget()) {
+                    return false;
+                }
+                replay.recordBlock((double)currentBlock.getTimestamp(), currentBlock.getTarget());
+            }
+
             if (currentBlock.getPreviousHash() != previousBlock.getHash()) {
                 return false;
             }
+
+            // PoS blocks must come from the leader of their slot
+            if (currentBlock.isProofOfStake()
+                && currentBlock.getValidator() != electValidator(currentBlock.getPreviousHash(),
+                                                                 currentBlock.getIndex(), validatorCounts[i])) {
+                return false;
+            }
         }
+        verifiedHeight = chain.size();
         return true;
     }
 
-    // Validator management
-    void addValidator(const std::string& address, double stake) {
-        validators.push_back(Validator(address, stake));
+    // Blocks up to a checkpoint matched by the chain are not validated
+    void addCheckpoint(uint64_t height, const std::string& hash) { checkpoints.add(height, hash); }
+
+    // Returns false if the signature of authority does not verify
+    bool addSignedCheckpoint(uint64_t height, const std::string& hash, const Signature& signature,
+                             const PublicKey& authority) {
+        return checkpoints.addSigned(height, hash, signature, authority);
     }
 
-    std::string selectValidator() {
-        double totalStake = 0;
-        for (const auto& v : validators) {
-            totalStake += v.stake;
-        }
+    // Blocks below it are known to be valid
+    size_t getVerifiedHeight() const { return verifiedHeight; }
 
-        double random = (double)rand() / RAND_MAX * totalStake;
-        double cumulative = 0;
+    // Makes the next isChainValid check the blocks from height on again;
+    // those up to a matched checkpoint stay trusted
+    void resetVerifiedHeight(size_t height = 1) {
+        verifiedHeight = std::min(verifiedHeight, std::max<size_t>(height, 1));
+    }
 
-        for (const auto& v : validators) {
-            cumulative += v.stake;
-            if (random <= cumulative) {
-                return v.address;
-            }
-        }
+    // Validator management
+    // A stake below 0 counts as 0
+    void addValidator(const std::string& address, double stake) {
+        validators.push_back(Validator(address, stake));
+        double previous = cumulativeStakes.empty() ? 0 : cumulativeStakes.back();
+        cumulativeStakes.push_back(previous + std::max(stake, 0.0));
+    }
 
-        return validators[0].address;
+    // Leader of the slot after previousHash, the same on every node
+    std::string selectValidator(const std::string& previousHash, uint64_t slot) const {
+        return electValidator(previousHash, slot, validators.size());
     }
 
     // Getters
-    BlockWithCA getLastBlock() const { return chain.back(); }
+    const BlockWithCA& getLastBlock() const { return chain.back(); }
     size_t getSize() const { return chain.size(); }
-    std::vector<Validator> getValidators() const { return validators; }
+    const std::vector<Validator>& getValidators() const { return validators; }
     HashMode getHashMode() const { return defaultHashMode; }
 
+    // Threads searching nonces in addBlockPoW; 1 keeps the serial loop.
+    // AC_HASH is slow, so its workers look for a solution or a
+    // cancellation every few nonces.
+    void setMiningThreads(unsigned threads) {
+        if (threads <= 1) {
+            miner.reset();
+        } else {
+            miner = std::make_shared<ParallelMiner>(threads, 4096, defaultHashMode == AC_HASH_MODE ? 4 : 256);
+        }
+    }
+    const MiningResult& getLastMiningResult() const { return lastMining; }
+
     // Change hash mode for future blocks
     void setHashMode(HashMode mode) { defaultHashMode = mode; }
     void setCaRule(uint32_t rule) { defaultCaRule = rule; }
     void setCaSteps(size_t steps) { defaultCaSteps = steps; }
+    // Older versions give the hashes of chains made before the validator
+    // and the target were hashed
+    void setBlockVersion(uint32_t version) { blockVersion = version; }
 
     // Get block at index
-    BlockWithCA getBlock(size_t index) const {
+    const BlockWithCA& getBlock(size_t index) const {
         if (index < chain.size()) {
             return chain[index];
         }
         return chain[0];
     }
+
+    // Writable block at index, e.g. to simulate a corrupted or forged chain;
+    // resetVerifiedHeight() makes isChainValid check it again
+    BlockWithCA& getMutableBlock(size_t index) { return chain[index]; }
 };
 
 #endif // BLOCKCHAIN_WITH_CA_H
\ No newline at end of file
@@ -8,6 +8,8 @@
 #include <chrono>
 #include <iomanip>
 #include <cmath>
+#include <atomic>
+#include <thread>
 
 void printSeparator() {
     std::cout << "========================================" << std::endl;
@@ -30,12 +32,12 @@ void compareHashPerformance() {
     BlockchainWithCA chainSHA(SHA256_MODE);
 
     auto startSHA = std::chrono::high_resolution_clock::now();
-    int totalIterationsSHA = 0;
+    uint64_t totalIterationsSHA = 0;
 
     for (int i = 0; i < NUM_BLOCKS; i++) {
-        int nonceStart = chainSHA.getLastBlock().getNonce();
+        uint64_t nonceStart = chainSHA.getLastBlock().getNonce();
         chainSHA.addBlockPoW(testTxs, DIFFICULTY);
-        int nonceEnd = chainSHA.getLastBlock().getNonce();
+        uint64_t nonceEnd = chainSHA.getLastBlock().getNonce();
         totalIterationsSHA += (nonceEnd - nonceStart);
     }
 
@@ -47,12 +49,12 @@ void compareHashPerformance() {
     BlockchainWithCA chainAC(AC_HASH_MODE, 30, 128);
 
     auto startAC = std::chrono::high_resolution_clock::now();
-    int totalIterationsAC = 0;
+    uint64_t totalIterationsAC = 0;
 
     for (int i = 0; i < NUM_BLOCKS; i++) {
-        int nonceStart = chainAC.getLastBlock().getNonce();
+        uint64_t nonceStart = chainAC.getLastBlock().getNonce();
         chainAC.addBlockPoW(testTxs, DIFFICULTY);
-        int nonceEnd = chainAC.getLastBlock().getNonce();
+        uint64_t nonceEnd = chainAC.getLastBlock().getNonce();
         totalIterationsAC += (nonceEnd - nonceStart);
     }
 
@@ -182,12 +184,12 @@ void compareRules() {
         BlockchainWithCA chain(AC_HASH_MODE, rule, 128);
 
         auto start = std::chrono::high_resolution_clock::now();
-        int totalIterations = 0;
+        uint64_t totalIterations = 0;
 
         for (int i = 0; i < NUM_BLOCKS; i++) {
-            int nonceStart = chain.getLastBlock().getNonce();
+            uint64_t nonceStart = chain.getLastBlock().getNonce();
             chain.addBlockPoW(testTxs, DIFFICULTY);
-            int nonceEnd = chain.getLastBlock().getNonce();
+            uint64_t nonceEnd = chain.getLastBlock().getNonce();
             totalIterations += (nonceEnd - nonceStart);
         }
 
@@ -223,12 +225,177 @@ void testValidation() {
     std::cout << "Validation result: " << (chain.isChainValid() ? "VALID ✓" : "INVALID ✗") << std::endl;
 }
 
+// PoS blocks must come from the stake-weighted leader of their slot
+void testProposerCheck() {
+    std::cout << "\n=== Proof of Stake: Proposer Check ===" << std::endl;
+    printSeparator();
+
+    BlockchainWithCA chain(SHA256_MODE);
+    chain.addValidator("Validator_A", 100);
+    chain.addValidator("Validator_B", 200);
+    chain.addValidator("Validator_C", 50);
+
+    std::vector<Transaction> txs;
+    txs.push_back(Transaction("TX1", "Alice", "Bob", 10.0));
+    for (int i = 0; i < 10; i++) {
+        chain.addBlockPoS(txs);
+    }
+
+    bool rederived = true;
+    for (size_t i = 1; i < chain.getSize(); i++) {
+        const BlockWithCA& block = chain.getBlock(i);
+        rederived = rederived && block.getValidator() == chain.selectValidator(block.getPreviousHash(), i);
+    }
+    std::cout << "Proposers re-derived from the chain: " << (rederived ? "YES" : "NO") << std::endl;
+    std::cout << "Chain valid: " << (chain.isChainValid() ? "YES" : "NO") << std::endl;
+
+    // Another validator claims the last block; its hash is recomputed, so
+    // only the leader check can catch it
+    BlockWithCA& last = chain.getMutableBlock(chain.getSize() - 1);
+    last.setValidator(last.getValidator() == "Validator_A" ? "Validator_B" : "Validator_A");
+    chain.resetVerifiedHeight();
+    std::cout << "Block from another validator rejected: " << (!chain.isChainValid() ? "YES" : "NO") << std::endl;
+}
+
+// isChainValid checks only the blocks above the verified height and the
+// last checkpoint matched
+void testIncrementalValidation() {
+    std::cout << "\n=== Incremental Validation and Checkpoints ===" << std::endl;
+    printSeparator();
+
+    BlockchainWithCA chain(SHA256_MODE);
+    std::vector<Transaction> txs;
+    txs.push_back(Transaction("TX1", "Alice", "Bob", 10.0));
+    for (int i = 0; i < 200; i++) {
+        chain.addBlockPoW(txs, 1);
+    }
+
+    auto startFull = std::chrono::high_resolution_clock::now();
+    bool fullValid = chain.isChainValid();
+    auto endFull = std::chrono::high_resolution_clock::now();
+    chain.addBlockPoW(txs, 1);
+    auto startTail = std::chrono::high_resolution_clock::now();
+    bool tailValid = chain.isChainValid();
+    auto endTail = std::chrono::high_resolution_clock::now();
+    std::cout << "Full validation: " << (fullValid ? "YES" : "NO") << " in "
+              << std::chrono::duration_cast<std::chrono::microseconds>(endFull - startFull).count()
+              << " us, then the new block alone: " << (tailValid ? "YES" : "NO") << " in "
+              << std::chrono::duration_cast<std::chrono::microseconds>(endTail - startTail).count() << " us" << std::endl;
+    std::cout << "Verified height: " << chain.getVerifiedHeight() << " of " << chain.getSize() << std::endl;
+
+    // A block below the verified height is changed: skipped until the
+    // verified height is reset
+    BlockchainWithCA tampered = chain;
+    tampered.getMutableBlock(50).setValidator("Mallory");
+    bool skipped = tampered.isChainValid();
+    tampered.resetVerifiedHeight();
+    std::cout << "Tampered block below the verified height skipped: " << (skipped ? "YES" : "NO")
+              << ", caught after resetVerifiedHeight: " << (!tampered.isChainValid() ? "YES" : "NO") << std::endl;
+
+    // A node starting from the same blocks trusts them up to a signed checkpoint
+    BlockchainWithCA restarted = chain;
+    restarted.resetVerifiedHeight();
+    Ed25519Key authority = Ed25519Key::generate();
+    std::string checkpointHash = chain.getBlock(180).getHash();
+    Signature checkpointSignature = Checkpoints::sign(authority, 180, checkpointHash);
+    std::cout << "Signed checkpoint at height 180 accepted: "
+              << (restarted.addSignedCheckpoint(180, checkpointHash, checkpointSignature, authority.publicKey())
+                  ? "YES" : "NO") << std::endl;
+    std::cout << "Same signature for another height rejected: "
+              << (!restarted.addSignedCheckpoint(179, checkpointHash, checkpointSignature, authority.publicKey())
+                  ? "YES" : "NO") << std::endl;
+    std::cout << "Chain validated from the checkpoint: "
+              << (restarted.isChainValid() && restarted.getVerifiedHeight() == restarted.getSize() ? "YES" : "NO")
+              << std::endl;
+
+    BlockchainWithCA forked = restarted;
+    forked.addCheckpoint(100, chain.getBlock(101).getHash());
+    std::cout << "Chain contradicting a checkpoint rejected: " << (!forked.isChainValid() ? "YES" : "NO") << std::endl;
+}
+
+// With retargeting on, each PoW target comes from the times of the
+// previous blocks and is checked again by isChainValid
+void testRetargeting() {
+    std::cout << "\n=== Difficulty Retargeting ===" << std::endl;
+    printSeparator();
+
+    std::vector<Transaction> txs;
+    txs.push_back(Transaction("TX1", "Alice", "Bob", 10.0));
+    for (uint32_t version : {CA_BLOCK_VERSION_TARGET, CA_BLOCK_VERSION_VALIDATOR}) {
+        BlockchainWithCA chain(SHA256_MODE);
+        chain.setBlockVersion(version);
+        chain.addValidator("Validator_A", 100);
+        chain.enableRetargeting(RetargetParams(1.0, 5, DifficultyTarget::fromLeadingZeroBits(8)));
+        for (int i = 0; i < 8; i++) {
+            chain.addBlockPoW(txs);
+            if (i % 3 == 0) {
+                chain.addBlockPoS(txs);
+            }
+        }
+        std::cout << "Version " << version << ", next target " << std::setprecision(2)
+                  << chain.getNextTarget().getDifficultyBits() << " bits, chain valid: "
+                  << (chain.isChainValid() ? "YES" : "NO") << std::endl;
+
+        // The last PoW block claims the easiest target: version 3 hashes the
+        // target, older versions are caught by the retargeting replay
+        size_t last = chain.getSize() - 1;
+        while (chain.getBlock(last).isProofOfStake()) {
+            last--;
+        }
+        chain.getMutableBlock(last).setTarget(DifficultyTarget());
+        bool hashBroken = chain.getBlock(last).getHash() != chain.getBlock(last).computeHash(chain.getBlock(last).getNonce());
+        chain.resetVerifiedHeight();
+        std::cout << "Changed target rejected: " << (!chain.isChainValid() ? "YES" : "NO")
+                  << ", hash broken: " << (hashBroken ? "YES" : "NO") << std::endl;
+    }
+}
+
+// The parallel miner finds the nonce the serial loop would, and stops
+// soon after a cancel even with slow AC_HASH candidates
+void testParallelMining() {
+    std::cout << "\n=== Parallel Mining ===" << std::endl;
+    printSeparator();
+
+    std::vector<Transaction> txs;
+    txs.push_back(Transaction("TX1", "Alice", "Bob", 10.0));
+    ParallelMiner miner(4, 4096, 4);
+    struct Case {
+        HashMode mode;
+        int difficulty;
+        const char* name;
+    };
+    for (const Case& c : {Case{SHA256_MODE, 4, "SHA256"}, Case{AC_HASH_MODE, 2, "AC_HASH"}}) {
+        BlockWithCA serial(1, "previous", txs, c.mode, 30, 128);
+        BlockWithCA parallel = serial;
+        serial.mineBlock(c.difficulty);
+        MiningResult mined = parallel.mineBlockParallel(c.difficulty, miner);
+        std::cout << c.name << ": same nonce and hash as serial mining: "
+                  << (mined.found && parallel.getNonce() == serial.getNonce() && parallel.getHash() == serial.getHash()
+                      ? "YES" : "NO") << " (nonce " << parallel.getNonce() << ")" << std::endl;
+    }
+
+    std::atomic<bool> cancel(false);
+    std::thread canceller([&cancel]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        cancel.store(true);
+    });
+    BlockWithCA abandoned(2, "previous", txs, AC_HASH_MODE, 30, 128);
+    MiningResult stopped = abandoned.mineBlockParallel(8, miner, &cancel);
+    canceller.join();
+    std::cout << "AC_HASH mining cancelled after " << (long)(stopped.seconds * 1000) << " ms: "
+              << (stopped.cancelled && !stopped.found && abandoned.getNonce() == 0 ? "YES" : "NO") << std::endl;
+}
+
 int main() {
     std::cout << "BLOCKCHAIN WITH CELLULAR AUTOMATON HASH" << std::endl;
     printSeparator();
 
     // Question 3: Integration test
     testValidation();
+    testProposerCheck();
+    testIncrementalValidation();
+    testRetargeting();
+    testParallelMining();
 
     // Question 4: Performance comparison
     compareHashPerformance();
@@ -0,0 +1,261 @@
+//
+// Created by abdelaziz on 10/17/2026.
+//
+
+#include "../0-Common/benchmark.h"
+#include "../0-Common/sha256_multibuffer.h"
+#include "../1-ArbredeMerkle/merkle_tree.h"
+#include "../2-ProofofWork/proof_of_work.h"
+#include "../3-ProofofStake/proof_of_stake.h"
+#include "../4-BlockchainComplete/complete_blockchain.h"
+
+// Hot paths of exercises 1 to 4: hashing, Merkle roots, nonce search,
+// validator selection and chain validation
+int main(int argc, char** argv) {
+    BenchmarkSuite suite("blockchain");
+    if(!suite.parseArguments(argc, argv)) {
+        return 2;
+    }
+
+    std::cout << "SHA-256 backend: " << sha256BackendName(sha256ActiveBackend()) << std::endl;
+
+    // SHA-256
+    std::string header80(80, 'h');
+    suite.run("sha256/openssl/80B", "hash", 1, [&]() {
+        benchmarkKeep(sha256Digest(header80));
+    });
+
+    std::vector<std::string> messages(16);
+    const uint8_t* pointers[16];
+    for(size_t i = 0; i < messages.size(); i++) {
+        messages[i] = std::string(64, (char)('a' + i));
+        pointers[i] = (const uint8_t*)messages[i].data();
+    }
+    Digest digests[16];
+    suite.run("sha256/batch16/64B", "hash", 16, [&]() {
+        sha256Batch(pointers, 64, 16, digests);
+        benchmarkKeep(digests);
+    });
+
+    // Merkle roots
+    std::vector<std::string> transactions;
+    for(size_t i = 0; i < 100000; i++) {
+        std::stringstream ss;
+        ss << "TX" << i << " Alice sends " << i % 97 << " BTC to Bob";
+        transactions.push_back(ss.str());
+    }
+    std::vector<std::string> small(transactions.begin(), transactions.begin() + 1000);
+    MerkleTree merkle;
+    suite.run("merkle/root/1k", "leaf", 1000, [&]() {
+        benchmarkKeep(merkle.getMerkleRootDigest(small));
+    });
+    suite.run("merkle/root/100k", "leaf", 100000, [&]() {
+        benchmarkKeep(merkle.getMerkleRootDigest(transactions));
+    });
+
+    // Nonce search: a zero target is never met, so every call scans the whole range
+    const uint64_t NONCES = 4096;
+    DifficultyTarget impossible((Digest()));
+    std::string prefix = "1" + std::string(64, 'f') + "Block 1 Data" + "1760000000";
+    suite.run("pow/nonce_search/text", "hash", NONCES, [&]() {
+        uint64_t found = 0, hashes = 0;
+        std::string hash;
+        benchmarkKeep(findNonceInRange(prefix, "", 1000000, 1000000 + NONCES - 1, impossible, found, hash, hashes));
+    });
+
+    BlockHeader wide;
+    uint8_t header[BlockHeader::MAX_SIZE];
+    wide.encode(header);
+    suite.run("pow/nonce_search/binary_header", "hash", NONCES, [&]() {
+        uint64_t found = 0, hashes = 0;
+        std::string hash;
+        benchmarkKeep(findHeaderNonceInRange(header, wide.size(), wide.nonceOffset(), 8,
+                                             0, NONCES - 1, impossible, found, hash, hashes));
+    });
+
+    Block block(1, std::string(64, 'f'), "Block 1 Data");
+    suite.run("pow/calculate_block_hash", "hash", 1, [&]() {
+        benchmarkKeep(block.calculateBlockHash());
+    });
+
+    // Validator selection
+    ProofOfStake fewValidators;
+    ProofOfStake manyValidators;
+    CompleteBlockchain completeValidators;
+    for(int i = 0; i < 1000; i++) {
+        std::stringstream ss;
+        ss << "Validator_" << i;
+        if(i < 4) {
+            fewValidators.addValidator(ss.str(), 50 * (i + 1));
+        }
+        manyValidators.addValidator(ss.str(), 1 + i % 300);
+        completeValidators.addValidator(ss.str(), 1 + i % 300);
+    }
+    suite.run("pos/select_validator/4", "selection", 1, [&]() {
+        benchmarkKeep(fewValidators.selectValidator());
+    });
+    suite.run("pos/select_validator/1000", "selection", 1, [&]() {
+        benchmarkKeep(manyValidators.selectValidator());
+    });
+    suite.run("complete/select_validator/1000", "selection", 1, [&]() {
+        benchmarkKeep(completeValidators.selectValidator());
+    });
+
+    // Stake index at 1M validators: tree and alias-table draws, stake updates
+    const size_t MILLION = 1000000;
+    StakeIndex stakeIndex;
+    for(size_t i = 0; i < MILLION; i++) {
+        stakeIndex.add(1 + (i * 7919) % 100000);
+    }
+    std::mt19937_64 stakeRng(42);
+    suite.run("pos/stake_index/sample/1M", "selection", 1, [&]() {
+        benchmarkKeep(stakeIndex.sample(stakeRng));
+    });
+    size_t updated = 0;
+    suite.run("pos/stake_index/set_stake/1M", "update", 1, [&]() {
+        updated = (updated + 104729) % MILLION;
+        stakeIndex.setStake(updated, 1 + updated % 1000);
+    });
+    suite.run("pos/stake_index/freeze/1M", "validator", (double)MILLION, [&]() {
+        stakeIndex.setStake(0, 1);
+        stakeIndex.freeze();
+    });
+    stakeIndex.freeze();
+    suite.run("pos/stake_index/sample_alias/1M", "selection", 1, [&]() {
+        benchmarkKeep(stakeIndex.sample(stakeRng));
+    });
+
+    // Epoch schedule at 1M validators: 32 slots, a proposer and 127 committee seats each
+    ValidatorRegistry millionRegistry;
+    for(size_t i = 0; i < MILLION; i++) {
+        millionRegistry.bond("V" + std::to_string(i), 1 + (i * 7919) % 100000);
+    }
+    ValidatorSnapshot millionSet = millionRegistry.snapshot();
+    std::string epochSeed(64, 'e');
+    suite.run("pos/epoch_schedule/1M/32x128", "seat", 32 * 128, [&]() {
+        benchmarkKeep(EpochScheduler::compute(millionSet, epochSeed, 1, 32, 127));
+    });
+    suite.run("pos/elect_leader/1M", "selection", 1, [&]() {
+        benchmarkKeep(electLeader(millionSet, epochSeed, 7));
+    });
+    EpochSchedule scheduled = EpochScheduler::compute(millionSet, epochSeed, 1, 32, 127);
+    suite.run("pos/epoch_schedule/proposer_lookup", "selection", 1, [&]() {
+        benchmarkKeep(scheduled.proposer(40));
+    });
+
+    // Chain validation, 100 blocks each. isChainValid only checks the blocks
+    // added since the last call, so the full benches reset the verified
+    // height first and the tail ones check the last block alone.
+    const int BLOCKS = 100;
+    Blockchain powChain;
+    for(int i = 1; i <= BLOCKS; i++) {
+        Block b(i, powChain.getLastBlock().getHash(), "Block data");
+        b.mineBlock(1);
+        powChain.addBlock(b);
+    }
+    suite.run("pow/is_chain_valid/100", "block", BLOCKS, [&]() {
+        powChain.resetVerifiedHeight();
+        benchmarkKeep(powChain.isChainValid());
+    });
+    suite.run("pow/is_chain_valid/tail", "block", 1, [&]() {
+        powChain.resetVerifiedHeight(BLOCKS);
+        benchmarkKeep(powChain.isChainValid());
+    });
+
+    BlockchainPoS posChain;
+    posChain.addValidator("Validator_A", 100);
+    posChain.addValidator("Validator_B", 200);
+    for(int i = 1; i <= BLOCKS; i++) {
+        posChain.addBlock(BlockPoS(i, posChain.getLastBlock().getHash(), "Block data"));
+    }
+    // Block signatures: after the first run they come from the verifier's cache
+    suite.run("pos/is_chain_valid/100", "block", BLOCKS, [&]() {
+        posChain.resetVerifiedHeight();
+        benchmarkKeep(posChain.isChainValid());
+    });
+    suite.run("pos/is_chain_valid/100/uncached", "block", BLOCKS, [&]() {
+        posChain.getVerifier().clearCache();
+        posChain.resetVerifiedHeight();
+        benchmarkKeep(posChain.isChainValid());
+    });
+    suite.run("pos/is_chain_valid/tail/uncached", "block", 1, [&]() {
+        posChain.getVerifier().clearCache();
+        posChain.resetVerifiedHeight(BLOCKS);
+        benchmarkKeep(posChain.isChainValid());
+    });
+
+    Ed25519Key signingKey = Ed25519Key::fromSeed(sha256Digest(std::string("bench key")));
+    std::vector<SignatureCheck> checks(BLOCKS);
+    for(int i = 0; i < BLOCKS; i++) {
+        checks[i].publicKey = signingKey.publicKey();
+        checks[i].message = sha256Digest(std::to_string(i));
+        checks[i].signature = signingKey.sign(checks[i].message);
+    }
+    suite.run("ed25519/sign", "signature", 1, [&]() {
+        benchmarkKeep(signingKey.sign(checks[0].message));
+    });
+    suite.run("ed25519/verify", "signature", 1, [&]() {
+        benchmarkKeep(ed25519Verify(checks[0].publicKey, checks[0].message.data(), 32, checks[0].signature));
+    });
+    SignatureVerifier batchVerifier(4);
+    suite.run("ed25519/verify_batch/100x4", "signature", BLOCKS, [&]() {
+        batchVerifier.clearCache();
+        benchmarkKeep(batchVerifier.verifyBatch(checks));
+    });
+
+    CompleteBlockchain completeChain;
+    completeChain.addValidator("Validator_A", 100);
+    for(int i = 1; i <= BLOCKS; i++) {
+        std::vector<Transaction> txs;
+        for(int t = 0; t < 10; t++) {
+            std::stringstream ss;
+            ss << "TX_" << i << "_" << t;
+            txs.push_back(Transaction(ss.str(), "Alice", "Bob", 1.0 + t));
+        }
+        completeChain.addBlockPoS(txs);
+    }
+    suite.run("complete/is_chain_valid/100x10tx", "block", BLOCKS, [&]() {
+        completeChain.resetVerifiedHeight();
+        benchmarkKeep(completeChain.isChainValid());
+    });
+    suite.run("complete/is_chain_valid/tail/10tx", "block", 1, [&]() {
+        completeChain.resetVerifiedHeight(BLOCKS);
+        benchmarkKeep(completeChain.isChainValid());
+    });
+    suite.run("complete/header_walk/100", "block", BLOCKS, [&]() {
+        uint64_t timestamps = 0;
+        for(const BlockHeader& header : completeChain.getHeaders()) {
+            timestamps += header.timestamp;
+        }
+        benchmarkKeep(timestamps);
+    });
+
+    // Block store: one 10-transaction block appended (encoded, checksummed,
+    // written) or read back through mmap and decoded
+    const std::string storeDirectory = "bench_store_tmp";
+    BlockStore::removeAll(storeDirectory);
+    {
+        BlockStore store(storeDirectory);
+        store.open();
+        const BlockComplete& sample = completeChain.getBlock(1);
+        Digest sampleHash;
+        hexToDigest(sample.getHash(), sampleHash);
+        suite.run("store/append/10tx", "block", 1, [&]() {
+            std::vector<uint8_t> bytes;
+            sample.encode(bytes);
+            sampleHash[0]++;
+            benchmarkKeep(store.append(store.size(), sampleHash, bytes));
+        });
+        uint64_t height = 0;
+        suite.run("store/read_decode/10tx", "block", 1, [&]() {
+            const uint8_t* data;
+            size_t length;
+            BlockComplete block;
+            height = height + 1 < store.size() ? height + 1 : 0;
+            benchmarkKeep(store.readRecord(height, data, length) && BlockComplete::decode(data, length, block));
+        });
+    }
+    BlockStore::removeAll(storeDirectory);
+
+    return suite.finish();
+}
@@ -0,0 +1,54 @@
+//
+// Created by abdelaziz on 10/17/2026.
+//
+
+#include "../0-Common/benchmark.h"
+#include "../5-CellularAutomatonHash/blockchain_with_ca_hash.h"
+
+// Exercise 5 uses its own Transaction and Validator types, so it is
+// measured in a separate program
+int main(int argc, char** argv) {
+    BenchmarkSuite suite("ca");
+    if(!suite.parseArguments(argc, argv)) {
+        return 2;
+    }
+
+    std::string input(100, 'x');
+    suite.run("ca/ac_hash/rule30/128_steps", "hash", 1, [&]() {
+        benchmarkKeep(ac_hash(input, 30, 128));
+    });
+    suite.run("ca/ac_hash/rule110/128_steps", "hash", 1, [&]() {
+        benchmarkKeep(ac_hash(input, 110, 128));
+    });
+
+    // PoS blocks so that building the chains does not depend on mining luck
+    const int BLOCKS = 20;
+    std::vector<Transaction> txs;
+    for(int t = 0; t < 5; t++) {
+        txs.push_back(Transaction("TX" + std::to_string(t), "Alice", "Bob", 1.0 + t));
+    }
+
+    BlockchainWithCA shaChain(SHA256_MODE);
+    BlockchainWithCA caChain(AC_HASH_MODE, 30, 128);
+    shaChain.addValidator("Validator_A", 100);
+    caChain.addValidator("Validator_A", 100);
+    for(int i = 0; i < BLOCKS; i++) {
+        shaChain.addBlockPoS(txs);
+        caChain.addBlockPoS(txs);
+    }
+    // Full validations: isChainValid alone would only check new blocks
+    suite.run("ca/is_chain_valid/sha256/20", "block", BLOCKS, [&]() {
+        shaChain.resetVerifiedHeight();
+        benchmarkKeep(shaChain.isChainValid());
+    });
+    suite.run("ca/is_chain_valid/ac_hash/20", "block", BLOCKS, [&]() {
+        caChain.resetVerifiedHeight();
+        benchmarkKeep(caChain.isChainValid());
+    });
+    suite.run("ca/is_chain_valid/ac_hash/tail", "block", 1, [&]() {
+        caChain.resetVerifiedHeight(BLOCKS);
+        benchmarkKeep(caChain.isChainValid());
+    });
+
+    return suite.finish();
+}